@@ -0,0 +1,263 @@
+#include "analyze.h"
+#include "bitboards.h"
+#include "moves.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Positions read but not yet written, per worker. Enough that a worker
+  // rarely waits for a slow position ahead of it to be written.
+  const size_t WindowPerWorker = 4;
+
+  // Bitboards::initialize trusts its input; this rejects lines it would
+  // misread: the placement must fill 8 ranks of 8 squares with one king a
+  // side, followed by the side to move, the castling rights ("-" or some of
+  // "KQkq") and the en passant square ("-" or one on rank 3 or 6).
+  bool plausibleFen(const std::string &fen)
+  {
+    std::istringstream in(fen);
+    std::string placement, side, castling, enPassant;
+    if (!(in >> placement >> side >> castling >> enPassant) || (side != "w" && side != "b"))
+    {
+      return false;
+    }
+    if (castling != "-" && castling.find_first_not_of("KQkq") != std::string::npos)
+    {
+      return false;
+    }
+    if (enPassant != "-" && (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+                             (enPassant[1] != '3' && enPassant[1] != '6')))
+    {
+      return false;
+    }
+
+    int ranks = 1, files = 0, whiteKings = 0, blackKings = 0;
+    for (char c : placement)
+    {
+      if (c == '/')
+      {
+        if (files != 8)
+        {
+          return false;
+        }
+        ranks++;
+        files = 0;
+      }
+      else if (c >= '1' && c <= '8')
+        files += c - '0';
+      else if (std::string("PNBRQKpnbrqk").find(c) != std::string::npos)
+      {
+        files++;
+        whiteKings += c == 'K';
+        blackKings += c == 'k';
+      }
+      else
+        return false;
+
+      if (files > 8)
+      {
+        return false;
+      }
+    }
+    return ranks == 8 && files == 8 && whiteKings == 1 && blackKings == 1;
+  }
+
+  // One line of output for 'fen'
+  std::string analysePosition(Searcher &searcher, const std::string &fen, const SearchLimits &limits)
+  {
+    std::ostringstream record;
+    record << fen << ',';
+    if (!plausibleFen(fen))
+    {
+      record << "invalid,0,0,0";
+      return record.str();
+    }
+
+    // A fresh table makes the result independent of what the worker searched before
+    searcher.tt->clear();
+    Bitboards board;
+    board.initialize(fen);
+    board.updateAttacks();
+    Move best = searcher.findBestMove(board, limits);
+    const SearchStats &stats = searcher.stats;
+    record << moveToUci(packMove(board, best)) << ',' << stats.score << ',' << stats.depth << ',' << stats.nodes;
+    return record.str();
+  }
+
+  // Reader, workers and writer meet here. Position i is queued as job i
+  // and its record lands in slot i % window; the reader may only run
+  // 'window' positions ahead of the writer, which is what bounds memory.
+  class Pipeline
+  {
+  public:
+    Pipeline(const SearchLimits &limits, int workers)
+      : limits(limits), slots(workers * WindowPerWorker), workerCount(workers),
+        tableMB(std::max<size_t>(1, TT.sizeMB() / workers))
+    {
+    }
+
+    uint64_t run(std::istream &in, std::ostream &out)
+    {
+      std::vector<std::thread> threads;
+      for (int i = 0; i < workerCount; i++)
+      {
+        threads.emplace_back(&Pipeline::work, this);
+      }
+      std::thread writer(&Pipeline::write, this, std::ref(out));
+
+      read(in);
+      for (std::thread &thread : threads)
+      {
+        thread.join();
+      }
+      writer.join();
+      return nextWrite;
+    }
+
+    uint64_t nodes = 0; // Searched by all workers
+
+  private:
+    struct Job
+    {
+      uint64_t index;
+      std::string fen;
+    };
+
+    struct Slot
+    {
+      bool ready = false;
+      std::string record;
+    };
+
+    const SearchLimits limits;
+    std::vector<Slot> slots;
+    int workerCount;
+    size_t tableMB; // Each worker's share of the hash size
+
+    std::mutex mutex;
+    std::condition_variable readerWait, workerWait, writerWait;
+    std::deque<Job> jobs;
+    uint64_t nextRead = 0, nextWrite = 0;
+    bool inputDone = false;
+
+    void read(std::istream &in)
+    {
+      std::string line;
+      while (std::getline(in, line))
+      {
+        if (!line.empty() && line.back() == '\r')
+        {
+          line.pop_back();
+        }
+        if (line.empty() || line[0] == '#')
+        {
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        readerWait.wait(lock, [this] { return nextRead - nextWrite < slots.size(); });
+        jobs.push_back({nextRead++, line});
+        workerWait.notify_one();
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      inputDone = true;
+      workerWait.notify_all();
+      writerWait.notify_one();
+    }
+
+    // Each worker keeps its Searcher, and so its pawn table, for all its
+    // positions, and searches with a transposition table of its own
+    void work()
+    {
+      TranspositionTable table;
+      table.resize(tableMB);
+      Searcher searcher;
+      searcher.tt = &table;
+      uint64_t searched = 0;
+      while (true)
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        workerWait.wait(lock, [this] { return !jobs.empty() || inputDone; });
+        if (jobs.empty())
+        {
+          nodes += searched;
+          return;
+        }
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        std::string record = analysePosition(searcher, job.fen, limits);
+        searched += searcher.stats.nodes;
+
+        lock.lock();
+        Slot &slot = slots[job.index % slots.size()];
+        slot.record = std::move(record);
+        slot.ready = true;
+        if (job.index == nextWrite)
+        {
+          writerWait.notify_one();
+        }
+      }
+    }
+
+    // Flushes whenever it has to wait, so records appear as soon as the
+    // ones before them are done
+    void write(std::ostream &out)
+    {
+      auto ready = [this] { return slots[nextWrite % slots.size()].ready || (inputDone && nextWrite == nextRead); };
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+        if (!ready())
+        {
+          lock.unlock();
+          out.flush();
+          lock.lock();
+          writerWait.wait(lock, ready);
+        }
+        if (inputDone && nextWrite == nextRead)
+        {
+          break;
+        }
+
+        Slot &slot = slots[nextWrite % slots.size()];
+        std::string record = std::move(slot.record);
+        slot.ready = false;
+        nextWrite++;
+        readerWait.notify_one();
+
+        lock.unlock();
+        out << record << '\n';
+        lock.lock();
+      }
+      lock.unlock();
+      out.flush();
+    }
+  };
+}
+
+uint64_t runAnalysis(std::istream &in, std::ostream &out, const SearchLimits &limits, int workers)
+{
+  workers = std::max(1, workers);
+  auto start = std::chrono::steady_clock::now();
+  Pipeline pipeline(limits, workers);
+  uint64_t positions = pipeline.run(in, out);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cerr << "Positions       : " << positions << "\n"
+            << "Workers         : " << workers << "\n"
+            << "Total time (ms) : " << int64_t(seconds * 1000) << "\n"
+            << "Positions/second: " << (seconds > 0 ? positions / seconds : 0) << "\n"
+            << "Nodes/second    : " << uint64_t(seconds > 0 ? pipeline.nodes / seconds : 0) << std::endl;
+  return positions;
+}
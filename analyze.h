@@ -0,0 +1,24 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+#include <cstdint>
+#include <iostream>
+#include "searcher.h"
+
+// Searches every FEN read from 'in' (one per line; blank lines and lines
+// starting with '#' are skipped) within 'limits', on 'workers' threads that
+// each own a single-threaded search. Writes one record per position to
+// 'out' as it streams through, in input order:
+//
+//   <fen>,<bestmove>,<score>,<depth>,<nodes>
+//
+// The move is in UCI form ("0000" if there is none, "invalid" for a line
+// that is not a FEN) and the score is in centipawns from white's point of
+// view. Each worker searches with its share of the hash size as a table
+// of its own, cleared for every position, so records do not depend on
+// scheduling (nor on the worker count, given the same share). At most a few positions per worker are held between reading and
+// writing, so memory stays flat however long the input is. Prints the
+// throughput to stderr and returns the number of records written.
+uint64_t runAnalysis(std::istream &in, std::ostream &out, const SearchLimits &limits, int workers);
+
+#endif // ANALYZE_H
@@ -0,0 +1,278 @@
+#include "attacks.h"
+#include "bitboards.h"
+#include <iostream>
+
+#ifdef HAS_PEXT_BACKEND
+#include <cpuid.h>
+#endif
+
+SliderBackend ActiveSliderBackend = MAGIC_BACKEND;
+Magic BishopMagics[64];
+Magic RookMagics[64];
+uint64_t BetweenSquares[64][64];
+uint64_t LineThrough[64][64];
+
+namespace
+{
+  // Total slice sizes over all squares: sum of 2^bits(mask)
+  uint64_t BishopTable[0x1480];
+  uint64_t RookTable[0x19000];
+
+  const uint64_t FileA = 0x0101010101010101ULL;
+  const uint64_t FileH = 0x8080808080808080ULL;
+  const uint64_t Rank8 = 0x00000000000000FFULL; // Row 0 (squares 0-7)
+  const uint64_t Rank1 = 0xFF00000000000000ULL; // Row 7 (squares 56-63)
+
+  // xorshift64* generator, used only to search for magic numbers
+  class Prng
+  {
+  public:
+    explicit Prng(uint64_t seed) : state(seed) {}
+
+    uint64_t rand64()
+    {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return state * 2685821657736338717ULL;
+    }
+
+    // Magics with few set bits are found much faster
+    uint64_t sparseRand64()
+    {
+      return rand64() & rand64() & rand64();
+    }
+
+  private:
+    uint64_t state;
+  };
+
+  // Slow reference slider used to fill the tables: walks each ray by
+  // (row, file) steps so it can never wrap around the board.
+  uint64_t slidingAttacks(int square, uint64_t occupied, bool diagonal)
+  {
+    static const int straightSteps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int diagonalSteps[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    const int(*steps)[2] = diagonal ? diagonalSteps : straightSteps;
+
+    uint64_t attacks = 0;
+    for (int d = 0; d < 4; d++)
+    {
+      int row = square / 8 + steps[d][0];
+      int file = square % 8 + steps[d][1];
+      while (row >= 0 && row < 8 && file >= 0 && file < 8)
+      {
+        uint64_t bit = 1ULL << (row * 8 + file);
+        attacks |= bit;
+        if (occupied & bit)
+          break;
+        row += steps[d][0];
+        file += steps[d][1];
+      }
+    }
+    return attacks;
+  }
+
+  void initLines()
+  {
+    for (int a = 0; a < 64; a++)
+    {
+      for (int b = 0; b < 64; b++)
+      {
+        BetweenSquares[a][b] = LineThrough[a][b] = 0;
+        if (a == b)
+        {
+          continue;
+        }
+
+        uint64_t bitA = 1ULL << a, bitB = 1ULL << b;
+        for (int diagonal = 0; diagonal < 2; diagonal++)
+        {
+          if (slidingAttacks(a, 0, diagonal) & bitB)
+          {
+            // The rays from each end meet exactly on the squares in between
+            BetweenSquares[a][b] = slidingAttacks(a, bitB, diagonal) & slidingAttacks(b, bitA, diagonal);
+            LineThrough[a][b] = (slidingAttacks(a, 0, diagonal) & slidingAttacks(b, 0, diagonal)) | bitA | bitB;
+          }
+        }
+      }
+    }
+  }
+
+  void initMagics(Magic magics[64], uint64_t *table, bool diagonal)
+  {
+    // Per-row seeds for the magic search; any seed works, these are just quick
+    static const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    uint64_t occupancy[4096], reference[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+    int size = 0;
+
+    for (int square = 0; square < 64; square++)
+    {
+      Magic &m = magics[square];
+
+      // Pieces on the board edge never block anything further along the ray,
+      // so they are left out of the mask (unless the slider stands on that edge).
+      uint64_t rowMask = Rank8 << (8 * (square / 8));
+      uint64_t fileMask = FileA << (square % 8);
+      uint64_t edges = ((Rank8 | Rank1) & ~rowMask) | ((FileA | FileH) & ~fileMask);
+
+      m.mask = slidingAttacks(square, 0, diagonal) & ~edges;
+      m.shift = 64 - __builtin_popcountll(m.mask);
+      m.attacks = square == 0 ? table : magics[square - 1].attacks + size;
+
+      // Enumerate every subset of the mask (Carry-Rippler trick)
+      size = 0;
+      uint64_t subset = 0;
+      do
+      {
+        occupancy[size] = subset;
+        reference[size] = slidingAttacks(square, subset, diagonal);
+        size++;
+        subset = (subset - m.mask) & m.mask;
+      } while (subset);
+
+      // PEXT maps the subsets one-to-one onto the slice; nothing to search for
+      if (ActiveSliderBackend == PEXT_BACKEND)
+      {
+        m.magic = 0;
+        for (int i = 0; i < size; i++)
+        {
+          m.attacks[m.index(occupancy[i])] = reference[i];
+        }
+        continue;
+      }
+
+      // Try random magics until every occupancy maps to a slot holding the
+      // right attacks. 'epoch' marks which slots were written in this attempt
+      // so the slice does not need clearing between attempts.
+      Prng rng(seeds[square / 8]);
+      for (int i = 0; i < size;)
+      {
+        for (m.magic = 0; __builtin_popcountll((m.magic * m.mask) >> 56) < 6;)
+        {
+          m.magic = rng.sparseRand64();
+        }
+
+        for (++attempt, i = 0; i < size; i++)
+        {
+          unsigned idx = m.index(occupancy[i]);
+          if (epoch[idx] < attempt)
+          {
+            epoch[idx] = attempt;
+            m.attacks[idx] = reference[i];
+          }
+          else if (m.attacks[idx] != reference[i])
+          {
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+bool cpuHasFastPext()
+{
+#ifdef HAS_PEXT_BACKEND
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & (1u << 8))) // CPUID.7.0:EBX[8] = BMI2
+  {
+    return false;
+  }
+
+  // AMD parts before Zen 3 (family 19h) implement PEXT in microcode, taking
+  // hundreds of cycles; the magic multiply is much faster there.
+  unsigned vendor[3] = {};
+  __get_cpuid(0, &eax, &vendor[0], &vendor[2], &vendor[1]);
+  bool amd = vendor[0] == 0x68747541 /* "Auth" */ || vendor[0] == 0x6F677948 /* "Hygo" */;
+  if (amd)
+  {
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned family = (eax >> 8) & 0xF;
+    if (family == 0xF)
+    {
+      family += (eax >> 20) & 0xFF;
+    }
+    return family >= 0x19;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char *sliderBackendName()
+{
+  return ActiveSliderBackend == PEXT_BACKEND ? "pext" : "magic";
+}
+
+void initAttacks(bool allowPext)
+{
+  ActiveSliderBackend = allowPext && cpuHasFastPext() ? PEXT_BACKEND : MAGIC_BACKEND;
+  initMagics(BishopMagics, BishopTable, true);
+  initMagics(RookMagics, RookTable, false);
+  initLines();
+}
+
+bool verifyAttackTables()
+{
+  Bitboards board; // Empty board, so the ray walker masks out no friendly pieces
+  Prng rng(1070372);
+
+  for (int diagonal = 0; diagonal < 2; diagonal++)
+  {
+    for (int square = 0; square < 64; square++)
+    {
+      const Magic &m = diagonal ? BishopMagics[square] : RookMagics[square];
+      uint64_t subset = 0;
+      do
+      {
+        // Squares outside the mask must not change the result
+        uint64_t occupied[2] = {subset, subset | (rng.rand64() & ~m.mask)};
+        for (uint64_t occ : occupied)
+        {
+          occ &= ~(1ULL << square);
+          uint64_t expected = board.generateSlidingAttacks(1ULL << square, occ, 0, diagonal);
+          uint64_t actual = diagonal ? bishopAttacks(square, occ) : rookAttacks(square, occ);
+          if (expected != actual)
+          {
+            std::cerr << (diagonal ? "Bishop" : "Rook") << " table mismatch on square " << square
+                      << " occupied " << occ << ": " << actual << " != " << expected << "\n";
+            return false;
+          }
+        }
+        subset = (subset - m.mask) & m.mask;
+      } while (subset);
+    }
+  }
+
+  for (int square = 0; square < 64; square++)
+  {
+    uint64_t piece = 1ULL << square;
+
+    // Shift formulas the old Bitboards::generateKnightAttacks and
+    // generateKingAttacks used. The king version had no file masks, so it
+    // wrapped between the a- and h-files; only those wrapped squares may differ.
+    uint64_t knight = ((piece << 17) & ~FileA) | ((piece << 15) & ~FileH) |
+                      ((piece << 10) & ~(FileA | (FileA << 1))) | ((piece << 6) & ~(FileH | (FileH >> 1))) |
+                      ((piece >> 17) & ~FileH) | ((piece >> 15) & ~FileA) |
+                      ((piece >> 10) & ~(FileH | (FileH >> 1))) | ((piece >> 6) & ~(FileA | (FileA << 1)));
+    uint64_t king = (piece << 8) | (piece >> 8) | (piece << 1) | (piece >> 1) |
+                    (piece << 9) | (piece << 7) | (piece >> 7) | (piece >> 9);
+    uint64_t wrapped = square % 8 == 0 ? FileH : square % 8 == 7 ? FileA : 0;
+
+    uint64_t whitePawn = board.generatePawnAttacks(piece, true);
+    uint64_t blackPawn = board.generatePawnAttacks(piece, false);
+
+    if (attacks<KNIGHT>(square) != knight || attacks<KING>(square) != (king & ~wrapped) ||
+        pawnAttacks(WHITE, square) != whitePawn || pawnAttacks(BLACK, square) != blackPawn)
+    {
+      std::cerr << "Leaper table mismatch on square " << square << "\n";
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,156 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <array>
+#include <cstdint>
+#include "types.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// PEXT is only available on x86-64. Define NO_PEXT to build without it.
+#if defined(__x86_64__) && !defined(NO_PEXT)
+#define HAS_PEXT_BACKEND
+#endif
+
+// Which indexing scheme the slider tables were built for
+enum SliderBackend
+{
+  MAGIC_BACKEND, // Portable multiply-shift magics
+  PEXT_BACKEND,  // BMI2 parallel bit extract
+};
+
+extern SliderBackend ActiveSliderBackend;
+
+// Precomputed sliding attack tables.
+// Each square owns a slice of a shared attack table. The occupied squares that
+// can block the slider are masked out and turned into an index into that
+// slice, either by a single PEXT (BMI2 CPUs) or by multiplying with the
+// square's magic number and shifting down ("fancy" magic bitboards).
+struct Magic
+{
+  uint64_t mask;     // Squares whose occupancy matters (board edges excluded)
+  uint64_t magic;    // Multiplier that hashes the masked occupancy (magic backend only)
+  uint64_t *attacks; // This square's slice of the attack table
+  unsigned shift;    // 64 - number of bits in 'mask'
+
+  unsigned index(uint64_t occupied) const
+  {
+#ifdef HAS_PEXT_BACKEND
+    if (ActiveSliderBackend == PEXT_BACKEND)
+    {
+#if defined(__BMI2__)
+      return unsigned(_pext_u64(occupied, mask));
+#else
+      // Built without -mbmi2: emit the instruction directly so this stays
+      // inlinable; it is only reached after CPUID reported BMI2.
+      uint64_t result;
+      __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(occupied), "r"(mask));
+      return unsigned(result);
+#endif
+    }
+#endif
+    return unsigned(((occupied & mask) * magic) >> shift);
+  }
+};
+
+extern Magic BishopMagics[64];
+extern Magic RookMagics[64];
+
+// Squares strictly between two squares on a common rank, file or diagonal
+// (empty otherwise), and the whole board-wide line through both of them.
+extern uint64_t BetweenSquares[64][64];
+extern uint64_t LineThrough[64][64];
+
+// Builds the bishop, rook and between/line tables. Must be called once
+// before any Bitboards attack or move generation. The PEXT backend is chosen when the
+// CPU has BMI2 with a fast (non-microcoded) PEXT, unless 'allowPext' is false.
+// Calling it again rebuilds the tables, e.g. to benchmark both backends.
+void initAttacks(bool allowPext = true);
+
+// True if this CPU supports BMI2 and executes PEXT in hardware
+bool cpuHasFastPext();
+
+// "pext" or "magic", for logging and benchmark records
+const char *sliderBackendName();
+
+// Compares every slider table entry against Bitboards::generateSlidingAttacks
+// and every leaper table against the shift formulas it replaced.
+// Returns false (and prints the first mismatch) if any entry differs.
+bool verifyAttackTables();
+
+// Squares reached from 'square' by each (row, file) step that stays on the board
+template <int N>
+constexpr std::array<uint64_t, 64> leaperTable(const int (&steps)[N][2])
+{
+  std::array<uint64_t, 64> table{};
+  for (int square = 0; square < 64; square++)
+  {
+    for (int i = 0; i < N; i++)
+    {
+      int row = square / 8 + steps[i][0];
+      int file = square % 8 + steps[i][1];
+      if (row >= 0 && row < 8 && file >= 0 && file < 8)
+      {
+        table[square] |= 1ULL << (row * 8 + file);
+      }
+    }
+  }
+  return table;
+}
+
+// Row 0 is rank 8, so white pawns attack towards lower rows
+constexpr int WhitePawnSteps[2][2] = {{-1, -1}, {-1, 1}};
+constexpr int BlackPawnSteps[2][2] = {{1, -1}, {1, 1}};
+constexpr int KnightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+constexpr int KingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+inline constexpr std::array<uint64_t, 64> PawnAttacks[2] = {leaperTable(WhitePawnSteps), leaperTable(BlackPawnSteps)};
+inline constexpr std::array<uint64_t, 64> KnightAttacks = leaperTable(KnightSteps);
+inline constexpr std::array<uint64_t, 64> KingAttacks = leaperTable(KingSteps);
+
+// Squares attacked by a bishop/rook/queen on 'square', including the first
+// blocker in every direction, whatever its color.
+inline uint64_t bishopAttacks(int square, uint64_t occupied)
+{
+  const Magic &m = BishopMagics[square];
+  return m.attacks[m.index(occupied)];
+}
+
+inline uint64_t rookAttacks(int square, uint64_t occupied)
+{
+  const Magic &m = RookMagics[square];
+  return m.attacks[m.index(occupied)];
+}
+
+inline uint64_t queenAttacks(int square, uint64_t occupied)
+{
+  return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+// Squares attacked by a piece of type Pt on 'square'. 'occupied' only matters
+// for sliders. Pawn attacks depend on color, so they have their own lookup.
+template <PieceType Pt>
+inline uint64_t attacks(int square, uint64_t occupied = 0)
+{
+  static_assert(Pt != PAWN, "use pawnAttacks() for pawns");
+
+  if constexpr (Pt == KNIGHT)
+    return KnightAttacks[square];
+  else if constexpr (Pt == BISHOP)
+    return bishopAttacks(square, occupied);
+  else if constexpr (Pt == ROOK)
+    return rookAttacks(square, occupied);
+  else if constexpr (Pt == QUEEN)
+    return queenAttacks(square, occupied);
+  else
+    return KingAttacks[square];
+}
+
+inline uint64_t pawnAttacks(Color color, int square)
+{
+  return PawnAttacks[color][square];
+}
+
+#endif // ATTACKS_H
@@ -0,0 +1,232 @@
+#include "batcheval.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "psqt.h"
+
+#ifdef HAS_AVX2_BACKEND
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  const Piece BatchPieces[12] = {WHITE_PAWN, WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING,
+                                 BLACK_PAWN, BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING};
+
+#ifdef HAS_AVX2_BACKEND
+  // values[i][b][v]: PSQT sum of BatchPieces[i] over the squares of the set
+  // bits of 'v' in byte 'b' of its bitboard. A bitboard's PSQ sum is then
+  // eight lookups however many pieces it holds, so the lookups of four
+  // positions can be gathered into one vector. One position at a time,
+  // walking the set bits takes fewer lookups.
+  struct PsqByteTables
+  {
+    Score values[12][8][256];
+  };
+
+  constexpr PsqByteTables buildPsqByteTables()
+  {
+    PsqByteTables t{};
+    for (int i = 0; i < 12; i++)
+    {
+      for (int b = 0; b < 8; b++)
+      {
+        for (int v = 0; v < 256; v++)
+        {
+          for (int bit = 0; bit < 8; bit++)
+          {
+            if (v & (1 << bit))
+            {
+              t.values[i][b][v] += PSQT.values[BatchPieces[i]][b * 8 + bit];
+            }
+          }
+        }
+      }
+    }
+    return t;
+  }
+
+  constexpr PsqByteTables PsqBytes = buildPsqByteTables();
+#endif
+
+  // Positions whose PSQ sum and phase are computed before the king shelter pass
+  const size_t BlockSize = 256;
+
+  const uint64_t FileA = 0x0101010101010101ULL;
+  const uint64_t FileH = 0x8080808080808080ULL;
+
+  void evaluateScalar(const PositionBatch &batch, size_t begin, size_t end, Score *score, int *phase)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      Score s = 0;
+      int p = 0;
+      for (int k = 0; k < 12; k++)
+      {
+        uint64_t bb = batch.pieces[BatchPieces[k]][i];
+        s += pieceEvaluation(bb, PSQT.values[BatchPieces[k]]);
+        p += PhaseWeight[typeOf(BatchPieces[k])] * __builtin_popcountll(bb);
+      }
+      uint64_t white = batch.pieces[WHITE_PAWN][i], black = batch.pieces[BLACK_PAWN][i];
+      s += evaluatePawns(white, black);
+      score[i - begin] = s;
+      phase[i - begin] = p;
+    }
+  }
+
+#ifdef HAS_AVX2_BACKEND
+  using namespace PawnTerms;
+
+  // evaluatePawns (pawns.cpp), four positions per vector, one per 64-bit
+  // lane: each step there has its vector form here. Scores are
+  // accumulated in the low 32 bits of each lane.
+  __attribute__((target("avx2"))) __m256i popcount4(__m256i v)
+  {
+    // Per-nibble counts by table lookup, summed per lane
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibbles = _mm256_set1_epi8(0x0F);
+    __m256i low = _mm256_and_si256(v, nibbles);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbles);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+  }
+
+  // count * value in the low 32 bits of each lane
+  __attribute__((target("avx2"))) __m256i times(__m256i count, Score value)
+  {
+    return _mm256_mul_epu32(count, _mm256_set1_epi64x(uint32_t(value)));
+  }
+
+  __attribute__((target("avx2"))) __m256i fillUp4(__m256i b)
+  {
+    b = _mm256_or_si256(b, _mm256_srli_epi64(b, 8));
+    b = _mm256_or_si256(b, _mm256_srli_epi64(b, 16));
+    return _mm256_or_si256(b, _mm256_srli_epi64(b, 32));
+  }
+
+  __attribute__((target("avx2"))) __m256i fillDown4(__m256i b)
+  {
+    b = _mm256_or_si256(b, _mm256_slli_epi64(b, 8));
+    b = _mm256_or_si256(b, _mm256_slli_epi64(b, 16));
+    return _mm256_or_si256(b, _mm256_slli_epi64(b, 32));
+  }
+
+  // a & ~b
+  __attribute__((target("avx2"))) __m256i andNot(__m256i a, __m256i b)
+  {
+    return _mm256_andnot_si256(b, a);
+  }
+
+  __attribute__((target("avx2"))) __m256i sideways4(__m256i b)
+  {
+    const __m256i fileA = _mm256_set1_epi64x(int64_t(FileA));
+    const __m256i fileH = _mm256_set1_epi64x(int64_t(FileH));
+    return _mm256_or_si256(andNot(_mm256_slli_epi64(b, 1), fileA), andNot(_mm256_srli_epi64(b, 1), fileH));
+  }
+
+  __attribute__((target("avx2"))) __m256i pawnSideAvx2(Color us, __m256i ours, __m256i theirs)
+  {
+    const __m256i fileA = _mm256_set1_epi64x(int64_t(FileA));
+    const __m256i fileH = _mm256_set1_epi64x(int64_t(FileH));
+
+    __m256i files = fillUp4(fillDown4(ours));
+    __m256i isolated = andNot(ours, sideways4(files));
+    __m256i doubled = _mm256_sub_epi64(popcount4(ours),
+                                       popcount4(_mm256_and_si256(files, _mm256_set1_epi64x(0xFF))));
+
+    __m256i stoppers = _mm256_or_si256(theirs, sideways4(theirs));
+    __m256i blocked = us == WHITE ? fillDown4(_mm256_slli_epi64(stoppers, 8)) : fillUp4(_mm256_srli_epi64(stoppers, 8));
+    __m256i passed = andNot(ours, blocked);
+
+    __m256i supported = sideways4(us == WHITE ? fillUp4(ours) : fillDown4(ours));
+    __m256i guarded = us == WHITE
+                          ? _mm256_slli_epi64(_mm256_or_si256(andNot(_mm256_slli_epi64(theirs, 7), fileH),
+                                                              andNot(_mm256_slli_epi64(theirs, 9), fileA)), 8)
+                          : _mm256_srli_epi64(_mm256_or_si256(andNot(_mm256_srli_epi64(theirs, 9), fileH),
+                                                              andNot(_mm256_srli_epi64(theirs, 7), fileA)), 8);
+    __m256i backward = _mm256_and_si256(andNot(andNot(ours, isolated), supported), guarded);
+
+    __m256i score = _mm256_add_epi64(times(doubled, Doubled), times(popcount4(isolated), Isolated));
+    score = _mm256_add_epi64(score, times(popcount4(backward), Backward));
+    for (int row = 1; row < 7; row++)
+    {
+      __m256i onRow = _mm256_and_si256(passed, _mm256_set1_epi64x(int64_t(0xFFULL << (8 * row))));
+      score = _mm256_add_epi64(score, times(popcount4(onRow), Passed[us == WHITE ? 7 - row : row]));
+    }
+    return score;
+  }
+
+  // 'end - begin' must be a multiple of 4
+  __attribute__((target("avx2"))) void evaluateAvx2(const PositionBatch &batch, size_t begin, size_t end,
+                                                    Score *score, int *phase)
+  {
+    const int *table = &PsqBytes.values[0][0][0];
+    const __m256i byteMask = _mm256_set1_epi64x(0xFF);
+    const __m256i evenLanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    for (size_t i = begin; i < end; i += 4)
+    {
+      // PSQ sums by byte-table gathers; these are 32-bit already
+      __m128i psq = _mm_setzero_si128();
+      __m256i p = _mm256_setzero_si256();
+      for (int k = 0; k < 12; k++)
+      {
+        __m256i bb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(batch.pieces[BatchPieces[k]] + i));
+        for (int b = 0; b < 8; b++)
+        {
+          __m256i index = _mm256_add_epi64(_mm256_and_si256(_mm256_srli_epi64(bb, 8 * b), byteMask),
+                                           _mm256_set1_epi64x((k * 8 + b) * 256));
+          psq = _mm_add_epi32(psq, _mm256_i64gather_epi32(table, index, 4));
+        }
+        int weight = PhaseWeight[typeOf(BatchPieces[k])];
+        if (weight)
+        {
+          p = _mm256_add_epi64(p, times(popcount4(bb), weight));
+        }
+      }
+
+      __m256i white = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(batch.pieces[WHITE_PAWN] + i));
+      __m256i black = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(batch.pieces[BLACK_PAWN] + i));
+      __m256i pawns = _mm256_sub_epi64(pawnSideAvx2(WHITE, white, black), pawnSideAvx2(BLACK, black, white));
+      __m128i pawns32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(pawns, evenLanes));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(score + (i - begin)), _mm_add_epi32(psq, pawns32));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(phase + (i - begin)),
+                       _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(p, evenLanes)));
+    }
+  }
+#endif
+}
+
+void evaluateBatch(const PositionBatch &batch, int *scores, bool allowAvx2)
+{
+  bool avx2 = allowAvx2 && cpuHasAvx2();
+  Score score[BlockSize];
+  int phase[BlockSize];
+
+  for (size_t begin = 0; begin < batch.count; begin += BlockSize)
+  {
+    size_t end = begin + BlockSize < batch.count ? begin + BlockSize : batch.count;
+    size_t vectorEnd = begin;
+#ifdef HAS_AVX2_BACKEND
+    if (avx2)
+    {
+      vectorEnd = begin + (end - begin) / 4 * 4;
+      evaluateAvx2(batch, begin, vectorEnd, score, phase);
+    }
+#else
+    (void)avx2;
+#endif
+    evaluateScalar(batch, vectorEnd, end, score + (vectorEnd - begin), phase + (vectorEnd - begin));
+
+    // The king shelter depends on one king square per side; cheap enough per position
+    const uint64_t *whitePawns = batch.pieces[WHITE_PAWN], *blackPawns = batch.pieces[BLACK_PAWN];
+    const uint64_t *whiteKings = batch.pieces[WHITE_KING], *blackKings = batch.pieces[BLACK_KING];
+    for (size_t i = begin; i < end; i++)
+    {
+      Score shield = evaluatePawnShield(whitePawns[i], blackPawns[i], whiteKings[i], blackKings[i]);
+      scores[i] = taper(score[i - begin] + shield, phase[i - begin]);
+    }
+  }
+}
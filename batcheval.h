@@ -0,0 +1,24 @@
+#ifndef BATCHEVAL_H
+#define BATCHEVAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Positions stored one array per piece bitboard (struct of arrays), so a
+// kernel can load the same piece's bitboard of several positions at once.
+// Position i has pieces[piece][i] for every Piece code a piece uses; the
+// other entries (NO_PIECE and the unused codes) are ignored.
+struct PositionBatch
+{
+  size_t count;
+  const uint64_t *pieces[16]; // By Piece
+};
+
+// Classical evaluation of every position in 'batch', in centipawns from
+// white's point of view, written to scores[0 .. count - 1]. Gives the
+// same scores as evaluateBoard. Material, piece-square values and phase
+// go four positions at a time through AVX2 when the CPU has it, unless
+// 'allowAvx2' is false; pawn structure is scored one position at a time.
+void evaluateBatch(const PositionBatch &batch, int *scores, bool allowAvx2 = true);
+
+#endif // BATCHEVAL_H
@@ -0,0 +1,525 @@
+#include "bench.h"
+#include "attacks.h"
+#include "batcheval.h"
+#include "bitboards.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "searcher.h"
+#include "tt.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+  // Opening, middlegame and endgame positions with varied branching
+  // factors. Changing this list changes the bench signature.
+  const char *const BenchFens[] = {
+      // Start position, perft reference positions and openings
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+      "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+
+      // Middlegames
+      "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+      "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+      "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+      "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+      "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+      "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+      "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+      "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+      "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+      "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+
+      // Endgames
+      "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+      "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+      "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+      "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+      "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+      "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+      "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+      "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+      "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+      "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+
+      // Long games, crowded boards
+      "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+      "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+      "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+      "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+      "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+
+      // Few pieces
+      "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+      "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+      "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+      "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+
+      // En passant, castling both ways, promotions
+      "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+      "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+      "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+  };
+}
+
+uint64_t runBench(int depth)
+{
+  // One thread and a fixed, freshly cleared table for every position, so
+  // the node count depends on nothing but the code
+  int savedThreads = searchThreads();
+  size_t savedHashMB = TT.sizeMB();
+  setSearchThreads(1);
+  TT.resize(16);
+
+  // Searched even where a loaded book has a move
+  SearchLimits limits = {};
+  limits.depth = depth;
+
+  const size_t count = sizeof(BenchFens) / sizeof(BenchFens[0]);
+  std::cout << "Slider backend  : " << sliderBackendName() << std::endl;
+  uint64_t nodes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++)
+  {
+    Bitboards board;
+    board.initialize(BenchFens[i]);
+    TT.clear();
+    searchBestMove(board, limits);
+    nodes += lastSearchStats().nodes;
+    std::cerr << "Position " << i + 1 << "/" << count << ": " << lastSearchStats().nodes << " nodes" << std::endl;
+  }
+  int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "Nodes searched  : " << nodes << "\n"
+            << "Total time (ms) : " << ms << "\n"
+            << "Nodes/second    : " << (ms > 0 ? nodes * 1000 / ms : 0) << std::endl;
+
+  setSearchThreads(savedThreads);
+  TT.resize(savedHashMB);
+  return nodes;
+}
+
+void runSmpScaling(int depth, int maxThreads)
+{
+  int savedThreads = searchThreads();
+  double baseSeconds = 0, baseNps = 0;
+  SearchLimits limits = {};
+  limits.depth = depth;
+
+  std::cout << "threads  time(ms)      nodes        nps  speedup  nps-scaling\n";
+  for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+  {
+    setSearchThreads(threadCount);
+    uint64_t nodes = 0;
+    double seconds = 0;
+
+    for (const char *fen : BenchFens)
+    {
+      Bitboards board;
+      board.initialize(fen);
+      TT.clear();
+
+      auto start = std::chrono::steady_clock::now();
+      searchBestMove(board, limits);
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      nodes += lastSearchStats().nodes;
+    }
+
+    double nps = seconds > 0 ? nodes / seconds : 0;
+    if (threadCount == 1)
+    {
+      baseSeconds = seconds;
+      baseNps = nps;
+    }
+
+    std::cout << std::setw(7) << threadCount << std::setw(10) << int64_t(seconds * 1000)
+              << std::setw(11) << nodes << std::setw(11) << uint64_t(nps)
+              << std::fixed << std::setprecision(2)
+              << std::setw(9) << (seconds > 0 ? baseSeconds / seconds : 0)
+              << std::setw(13) << (baseNps > 0 ? nps / baseNps : 0)
+              << std::defaultfloat << std::endl;
+  }
+
+  setSearchThreads(savedThreads);
+}
+
+bool runEvalBench()
+{
+  const int Rounds = 400;
+  std::vector<Bitboards> boards;
+  std::vector<MoveList> moveLists;
+  for (const char *fen : BenchFens)
+  {
+    boards.emplace_back();
+    boards.back().initialize(fen);
+    moveLists.push_back(generateLegalMoves(boards.back(), boards.back().whiteToMove));
+  }
+
+  NnueBackend savedBackend = ActiveNnueBackend;
+  std::vector<int> reference; // Scores from the first NNUE kernel set
+  bool ok = true;
+
+  std::cout << "evaluator      evals/s  (make + evaluate + unmake per legal move)\n";
+  for (int run = 0; run < 3; run++)
+  {
+    bool nnue = run > 0;
+    if (nnue && (!networkLoaded() || (run == 2 && !cpuHasAvx2())))
+    {
+      continue;
+    }
+    if (nnue)
+    {
+      setNnueBackend(run == 1 ? NNUE_SCALAR : NNUE_AVX2);
+    }
+
+    PawnTable pawns;
+    Accumulator root, child;
+    uint64_t evals = 0;
+    int64_t checksum = 0;
+    std::vector<int> scores;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < Rounds; round++)
+    {
+      for (size_t i = 0; i < boards.size(); i++)
+      {
+        Bitboards &board = boards[i];
+        if (nnue)
+        {
+          refreshAccumulator(board, root);
+        }
+        for (PackedMove move : moveLists[i])
+        {
+          UndoInfo undo;
+          board.makeMove(move, undo);
+          int score;
+          if (nnue)
+          {
+            updateAccumulator(root, child, board, move, undo.capturedPiece);
+            score = evaluateNnue(board, child);
+          }
+          else
+          {
+            score = evaluateBoard(board, pawns);
+          }
+
+          // The first round doubles as the correctness check
+          if (round == 0 && nnue)
+          {
+            Accumulator fresh;
+            refreshAccumulator(board, fresh);
+            if (std::memcmp(&fresh, &child, sizeof(fresh)) != 0)
+            {
+              std::cerr << "Incremental accumulator differs after " << moveToString(move)
+                        << " in " << BenchFens[i] << std::endl;
+              ok = false;
+            }
+            scores.push_back(score);
+          }
+          board.unmakeMove(move, undo);
+          checksum += score;
+          evals++;
+        }
+      }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (nnue && reference.empty())
+    {
+      reference = scores;
+    }
+    else if (nnue && scores != reference)
+    {
+      std::cerr << "NNUE " << nnueBackendName(ActiveNnueBackend) << " scores differ from the scalar kernels" << std::endl;
+      ok = false;
+    }
+
+    std::string name = nnue ? std::string("nnue-") + nnueBackendName(ActiveNnueBackend) : "classical";
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(11)
+              << uint64_t(seconds > 0 ? evals / seconds : 0) << "  (checksum " << checksum << ")" << std::endl;
+  }
+
+  ActiveNnueBackend = savedBackend;
+  return ok;
+}
+
+bool runBatchBench(size_t count)
+{
+  // Random games of up to 40 plies from each bench position; xorshift so
+  // every run measures the same positions
+  std::vector<Bitboards> boards;
+  boards.reserve(count);
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  for (size_t game = 0; boards.size() < count; game++)
+  {
+    Bitboards board;
+    board.initialize(BenchFens[game % (sizeof(BenchFens) / sizeof(BenchFens[0]))]);
+    for (int ply = 0; ply < 40 && boards.size() < count; ply++)
+    {
+      MoveList moves = generateLegalMoves(board, board.whiteToMove);
+      if (moves.empty())
+      {
+        break;
+      }
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      UndoInfo undo;
+      board.makeMove(moves[seed % moves.size()], undo);
+      boards.push_back(board);
+    }
+  }
+
+  std::vector<uint64_t> arrays[16];
+  PositionBatch batch = {};
+  batch.count = count;
+  for (int piece = 0; piece < 16; piece++)
+  {
+    if (typeOf(Piece(piece)) == NO_PIECE_TYPE || typeOf(Piece(piece)) > KING)
+    {
+      continue;
+    }
+    arrays[piece].resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      arrays[piece][i] = boards[i].pieces(Piece(piece));
+    }
+    batch.pieces[piece] = arrays[piece].data();
+  }
+
+  std::vector<int> expected(count), scores(count);
+  bool ok = true;
+  double baseRate = 0;
+
+  std::cout << "method          positions/s  speedup\n";
+  for (int run = 0; run < 3; run++)
+  {
+    if (run == 2 && !cpuHasAvx2())
+    {
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (run == 0)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        Bitboards board = boards[i];
+        expected[i] = evaluateBoard(board);
+      }
+    }
+    else
+    {
+      evaluateBatch(batch, scores.data(), run == 2);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (run > 0 && scores != expected)
+    {
+      std::cerr << "Batch scores differ from evaluateBoard" << std::endl;
+      ok = false;
+    }
+
+    double rate = seconds > 0 ? count / seconds : 0;
+    if (run == 0)
+    {
+      baseRate = rate;
+    }
+    const char *names[3] = {"per-position", "batch-scalar", "batch-avx2"};
+    std::cout << std::left << std::setw(14) << names[run] << std::right << std::setw(13) << uint64_t(rate)
+              << std::fixed << std::setprecision(2) << std::setw(9) << (baseRate > 0 ? rate / baseRate : 0)
+              << std::defaultfloat << std::endl;
+  }
+  return ok;
+}
+
+namespace
+{
+  // One kernel of the micro benchmark. 'pass' runs it over the whole
+  // corpus and returns how many calls that made.
+  struct MicroKernel
+  {
+    const char *name;
+    std::function<uint64_t()> pass;
+  };
+
+  // Results are folded in here so the compiler cannot drop the calls
+  volatile uint64_t microSink;
+
+  const int MicroSamples = 25;
+  const double MicroSampleSeconds = 0.004;
+
+  double secondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+void runMicroBench(const std::string &csvPath)
+{
+  std::vector<Bitboards> boards;
+  std::vector<MoveMasks> masks;
+  std::vector<MoveList> moves;
+  for (const char *fen : BenchFens)
+  {
+    boards.emplace_back();
+    boards.back().initialize(fen);
+    boards.back().updateAttacks();
+    masks.push_back(computeMoveMasks(boards.back(), boards.back().whiteToMove));
+    moves.push_back(generateLegalMoves(boards.back(), boards.back().whiteToMove));
+  }
+
+  // A generate*Moves kernel: one call per position, into a reused list
+  auto pieceGenerator = [&](void (*generate)(const Bitboards &, bool, const MoveMasks &, MoveList &)) {
+    return [&, generate]() -> uint64_t {
+      MoveList list;
+      for (size_t i = 0; i < boards.size(); i++)
+      {
+        list.clear();
+        generate(boards[i], boards[i].whiteToMove, masks[i], list);
+        microSink = microSink + list.size();
+      }
+      return boards.size();
+    };
+  };
+
+  std::vector<MicroKernel> kernels = {
+      {"generateLegalMoves", [&]() -> uint64_t {
+         for (const Bitboards &board : boards)
+           microSink = microSink + generateLegalMoves(board, board.whiteToMove).size();
+         return boards.size();
+       }},
+      {"computeMoveMasks", [&]() -> uint64_t {
+         for (const Bitboards &board : boards)
+           microSink = microSink + computeMoveMasks(board, board.whiteToMove).targets;
+         return boards.size();
+       }},
+      {"generatePawnMoves", pieceGenerator(generatePawnMoves)},
+      {"generateKnightMoves", pieceGenerator(generateKnightMoves)},
+      {"generateBishopMoves", pieceGenerator(generateBishopMoves)},
+      {"generateRookMoves", pieceGenerator(generateRookMoves)},
+      {"generateQueenMoves", pieceGenerator(generateQueenMoves)},
+      {"generateKingMoves", pieceGenerator(generateKingMoves)},
+      {"simulateMove", [&]() -> uint64_t {
+         uint64_t calls = 0;
+         for (size_t i = 0; i < boards.size(); i++)
+         {
+           for (PackedMove move : moves[i])
+           {
+             microSink = microSink + boards[i].simulateMove(move).key;
+             calls++;
+           }
+         }
+         return calls;
+       }},
+      {"makeMove+unmakeMove", [&]() -> uint64_t {
+         uint64_t calls = 0;
+         for (size_t i = 0; i < boards.size(); i++)
+         {
+           for (PackedMove move : moves[i])
+           {
+             UndoInfo undo;
+             boards[i].makeMove(move, undo);
+             microSink = microSink + boards[i].key;
+             boards[i].unmakeMove(move, undo);
+             calls++;
+           }
+         }
+         return calls;
+       }},
+      {"updateAttacks", [&]() -> uint64_t {
+         for (Bitboards &board : boards)
+         {
+           board.updateAttacks();
+           microSink = microSink + board.whitePieceAttacks;
+         }
+         return boards.size();
+       }},
+      {"generateSlidingAttacks", [&]() -> uint64_t {
+         // Both sides' straight and diagonal sliders of each position
+         for (const Bitboards &board : boards)
+         {
+           uint64_t occupied = board.whitePieces | board.blackPieces;
+           microSink = microSink +
+                       board.generateSlidingAttacks(board.whiteRooks | board.whiteQueens, occupied, board.whitePieces, false) +
+                       board.generateSlidingAttacks(board.whiteBishops | board.whiteQueens, occupied, board.whitePieces, true) +
+                       board.generateSlidingAttacks(board.blackRooks | board.blackQueens, occupied, board.blackPieces, false) +
+                       board.generateSlidingAttacks(board.blackBishops | board.blackQueens, occupied, board.blackPieces, true);
+         }
+         return boards.size() * 4;
+       }},
+      {"evaluateBoard", [&]() -> uint64_t {
+         for (const Bitboards &board : boards)
+           microSink = microSink + evaluateBoard(board);
+         return boards.size();
+       }},
+  };
+
+  std::ofstream csv;
+  if (!csvPath.empty())
+  {
+    csv.open(csvPath);
+    csv << "# slider backend " << sliderBackendName() << "\n";
+    csv << "kernel,median_ns,cv,samples\n";
+  }
+
+  std::cout << "slider backend: " << sliderBackendName() << "\n";
+  std::cout << "kernel                    median ns/op      cv\n";
+  for (const MicroKernel &kernel : kernels)
+  {
+    // Warm up caches and branch predictors, then size the samples so
+    // each one runs for a few milliseconds
+    auto start = std::chrono::steady_clock::now();
+    uint64_t passes = 0;
+    do
+    {
+      kernel.pass();
+      passes++;
+    } while (secondsSince(start) < MicroSampleSeconds);
+    uint64_t passesPerSample = std::max<uint64_t>(1, uint64_t(passes * MicroSampleSeconds / secondsSince(start)));
+
+    std::vector<double> samples;
+    uint64_t calls = 0;
+    for (int s = 0; s < MicroSamples; s++)
+    {
+      calls = 0;
+      start = std::chrono::steady_clock::now();
+      for (uint64_t p = 0; p < passesPerSample; p++)
+      {
+        calls += kernel.pass();
+      }
+      samples.push_back(secondsSince(start) * 1e9 / calls);
+    }
+
+    double mean = 0, variance = 0;
+    for (double ns : samples)
+      mean += ns / samples.size();
+    for (double ns : samples)
+      variance += (ns - mean) * (ns - mean) / samples.size();
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+    double cv = mean > 0 ? std::sqrt(variance) / mean : 0;
+
+    std::cout << std::left << std::setw(24) << kernel.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(14) << median
+              << std::setprecision(2) << std::setw(7) << cv * 100 << "%" << std::defaultfloat << std::endl;
+    if (csv.is_open())
+    {
+      csv << kernel.name << "," << std::fixed << std::setprecision(2) << median << ","
+          << std::setprecision(4) << cv << std::defaultfloat << "," << samples.size() << "\n";
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Searches the fixed bench positions one after another to 'depth' on one
+// thread, with a cleared 16 MB table for each, and prints the total nodes,
+// time and nodes/second. The node count is the same on every machine and
+// run, so it changes only when the search tree does (the evaluator
+// selected counts too). Returns the node count.
+uint64_t runBench(int depth);
+
+// Searches a fixed position set to 'depth' with 1, 2, 4, ... 'maxThreads'
+// threads and prints time-to-depth, nodes/second and the speedup of each
+// over one thread. The table is cleared before every position.
+void runSmpScaling(int depth, int maxThreads);
+
+// Plays every legal move of the same positions, evaluates the result and
+// takes it back, and prints evaluations/second for the classical evaluator
+// and for each NNUE kernel set this CPU runs (if a network is loaded).
+// Returns false if incremental and refreshed accumulators, or the kernel
+// sets, disagree.
+bool runEvalBench();
+
+// Evaluates 'count' positions reached by random play from the same set,
+// once per position through a Bitboards copy and evaluateBoard, and in one
+// evaluateBatch call with and without AVX2. Prints positions/second of
+// each and returns false if any score differs.
+bool runBatchBench(size_t count);
+
+// Times the move generation, make/unmake, attack and evaluation kernels
+// one at a time over the bench positions. Each is warmed up and then
+// sampled repeatedly; prints the median ns per call and the coefficient
+// of variation of the samples, and also writes them as CSV to 'csvPath'
+// unless it is empty.
+void runMicroBench(const std::string &csvPath);
+
+#endif // BENCH_H
@@ -1,27 +1,36 @@
 // Example method implementation
 #include "bitboards.h"
 #include "moves.h"
+#include "attacks.h"
+#include "evaluation.h"
 #include <sstream>
 #include <cctype>
 #include <iostream>
 #include <iomanip>
 #include <cstdint>
+#include <cassert>
 
 Bitboards::Bitboards()
     : whitePawns(0), whiteRooks(0), whiteKnights(0), whiteBishops(0),
       whiteQueens(0), whiteKings(0), blackPawns(0), blackRooks(0),
       blackKnights(0), blackBishops(0), blackQueens(0), blackKings(0),
-      whitePieces(0), blackPieces(0),
+      whitePieces(0), blackPieces(0), pieceOn(),
       whitePawnAttacks(0), whiteRookAttacks(0), whiteKnightAttacks(0), whiteBishopAttacks(0),
       whiteQueenAttacks(0), whiteKingAttacks(0), blackPawnAttacks(0), blackRookAttacks(0),
       blackKnightAttacks(0), blackBishopAttacks(0), blackQueenAttacks(0), blackKingAttacks(0),
       whitePieceAttacks(0), blackPieceAttacks(0),
-      whiteToMove(true), enPassantSquare(-1),
+      key(0), pawnKey(0), psqScore(0), phase(0), enPassantSquare(-1), halfmoveClock(0), whiteToMove(true),
       whiteKingCastle(false), whiteQueenCastle(false), blackKingCastle(false), blackQueenCastle(false),
       checkmate(false), stalemate(false)
 {
 }
 
+uint64_t Bitboards::*const Bitboards::PieceBoards[16] = {
+    nullptr, &Bitboards::whitePawns, &Bitboards::whiteKnights, &Bitboards::whiteBishops,
+    &Bitboards::whiteRooks, &Bitboards::whiteQueens, &Bitboards::whiteKings, nullptr,
+    nullptr, &Bitboards::blackPawns, &Bitboards::blackKnights, &Bitboards::blackBishops,
+    &Bitboards::blackRooks, &Bitboards::blackQueens, &Bitboards::blackKings, nullptr};
+
 void Bitboards::setBit(uint64_t &bitboard, int square)
 {
   bitboard |= (1ULL << square);
@@ -37,6 +46,9 @@ void Bitboards::initialize(string fen)
   blackPawnAttacks = blackRookAttacks = blackKnightAttacks = blackBishopAttacks = blackQueenAttacks = blackKingAttacks = 0;
   whitePieceAttacks = blackPieceAttacks = 0;
 
+  enPassantSquare = -1;
+  halfmoveClock = 0;
+  whiteKingCastle = whiteQueenCastle = blackKingCastle = blackQueenCastle = false;
   checkmate = false;
   stalemate = false;
 
@@ -107,15 +119,9 @@ void Bitboards::initialize(string fen)
     }
   }
 
+  // Fields after the placement may be missing; they then read as "w" and "-"
   index++;
-  if (fen[index] == 'w')
-  {
-    whiteToMove = true;
-  }
-  else if (fen[index == 'b'])
-  {
-    whiteToMove = false;
-  }
+  whiteToMove = !(index < length && fen[index] == 'b');
 
   for (index += 2; index < length; index++)
   {
@@ -145,15 +151,110 @@ void Bitboards::initialize(string fen)
   }
 
   index++;
-  if (fen[index] != '-')
+  if (index + 1 < length && fen[index] >= 'a' && fen[index] <= 'h' && (fen[index + 1] == '3' || fen[index + 1] == '6'))
   {
     int file = fen[index++] - 'a';
     int rank = fen[index++] - '0';
     enPassantSquare = (8 - rank) * 8 + file;
   }
+  else
+  {
+    index++;
+  }
+
+  // Halfmove clock (optional)
+  while (index < length && fen[index] == ' ')
+  {
+    index++;
+  }
+  while (index < length && std::isdigit(fen[index]))
+  {
+    halfmoveClock = halfmoveClock * 10 + (fen[index++] - '0');
+  }
 
   whitePieces = whitePawns | whiteRooks | whiteKnights | whiteBishops | whiteQueens | whiteKings;
   blackPieces = blackPawns | blackRooks | blackKnights | blackBishops | blackQueens | blackKings;
+
+  // Fill the mailbox from the piece bitboards
+  for (int square = 0; square < 64; square++)
+  {
+    pieceOn[square] = NO_PIECE;
+  }
+  for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++)
+  {
+    if (!PieceBoards[piece])
+    {
+      continue;
+    }
+    for (uint64_t b = this->*PieceBoards[piece]; b; b &= b - 1)
+    {
+      pieceOn[__builtin_ctzll(b)] = piece;
+    }
+  }
+
+  key = computeKey();
+  pawnKey = computePawnKey();
+  psqScore = computePsqScore();
+  phase = computePhase();
+}
+
+Score Bitboards::computePsqScore() const
+{
+  Score score = 0;
+  for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++)
+  {
+    if (PieceBoards[piece])
+    {
+      score += pieceEvaluation(this->*PieceBoards[piece], PSQT.values[piece]);
+    }
+  }
+  return score;
+}
+
+int Bitboards::computePhase() const
+{
+  int total = 0;
+  for (int square = 0; square < 64; square++)
+  {
+    total += PhaseWeight[typeOf(pieceAt(square))];
+  }
+  return total;
+}
+
+uint64_t Bitboards::computePawnKey() const
+{
+  uint64_t k = 0;
+  for (uint64_t b = whitePawns; b; b &= b - 1)
+  {
+    k ^= Zobrist.pieces[WHITE_PAWN][__builtin_ctzll(b)];
+  }
+  for (uint64_t b = blackPawns; b; b &= b - 1)
+  {
+    k ^= Zobrist.pieces[BLACK_PAWN][__builtin_ctzll(b)];
+  }
+  return k;
+}
+
+uint64_t Bitboards::computeKey() const
+{
+  uint64_t k = 0;
+  for (int square = 0; square < 64; square++)
+  {
+    if (pieceOn[square] != NO_PIECE)
+    {
+      k ^= Zobrist.pieces[pieceOn[square]][square];
+    }
+  }
+  k ^= castlingKey();
+  if (enPassantSquare != -1)
+  {
+    k ^= Zobrist.enPassant[enPassantSquare % 8];
+  }
+  if (!whiteToMove)
+  {
+    k ^= Zobrist.side;
+  }
+  return k;
 }
 
 void Bitboards::updateAttacks()
@@ -182,7 +283,7 @@ void Bitboards::updateAttacks()
   blackPieceAttacks = blackPawnAttacks | blackRookAttacks | blackKnightAttacks | blackBishopAttacks | blackQueenAttacks | blackKingAttacks;
 }
 
-uint64_t Bitboards::generatePawnAttacks(uint64_t pawns, bool isWhite)
+uint64_t Bitboards::generatePawnAttacks(uint64_t pawns, bool isWhite) const
 {
   uint64_t attacks = 0;
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
@@ -206,35 +307,23 @@ uint64_t Bitboards::generatePawnAttacks(uint64_t pawns, bool isWhite)
   return attacks;
 }
 
-uint64_t Bitboards::generateKnightAttacks(uint64_t knights, bool isWhite)
+uint64_t Bitboards::generateKnightAttacks(uint64_t knights, bool isWhite) const
 {
-  uint64_t attacks = 0;
+  uint64_t knightMoves = 0;
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
   while (knights)
   {
-    int square = __builtin_ctzll(knights);
-    uint64_t singleKnight = 1ULL << square;
-
-    uint64_t knightMoves =
-        ((singleKnight << 17) & ~0x0101010101010101ULL) |
-        ((singleKnight << 15) & ~0x8080808080808080ULL) |
-        ((singleKnight << 10) & ~0x0303030303030303ULL) |
-        ((singleKnight << 6) & ~0xC0C0C0C0C0C0C0C0ULL) |
-        ((singleKnight >> 17) & ~0x8080808080808080ULL) |
-        ((singleKnight >> 15) & ~0x0101010101010101ULL) |
-        ((singleKnight >> 10) & ~0xC0C0C0C0C0C0C0C0ULL) |
-        ((singleKnight >> 6) & ~0x0303030303030303ULL);
-
-    // Remove attacks on friendly pieces
-    knightMoves &= ~friendlies;
-
-    attacks |= knightMoves;
+    knightMoves |= attacks<KNIGHT>(__builtin_ctzll(knights));
     knights &= knights - 1;
   }
-  return attacks;
+
+  // Remove attacks on friendly pieces
+  return knightMoves & ~friendlies;
 }
 
-uint64_t Bitboards::generateSlidingAttacks(uint64_t piece, uint64_t occupied, uint64_t friendlies, bool diagonal)
+// Ray-walking slider generator. No longer used for move generation (see
+// attacks.h); kept as the reference that verifyAttackTables() checks against.
+uint64_t Bitboards::generateSlidingAttacks(uint64_t piece, uint64_t occupied, uint64_t friendlies, bool diagonal) const
 {
   uint64_t attacks = 0;
   int directions[4];
@@ -293,77 +382,80 @@ uint64_t Bitboards::generateSlidingAttacks(uint64_t piece, uint64_t occupied, ui
   return attacks;
 }
 
-uint64_t Bitboards::generateBishopAttacks(uint64_t bishops, uint64_t occupied, bool isWhite)
+uint64_t Bitboards::generateBishopAttacks(uint64_t bishops, uint64_t occupied, bool isWhite) const
 {
   uint64_t attacks = 0;
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
 
   while (bishops)
   {
-    int square = __builtin_ctzll(bishops);
-    uint64_t singleBishop = 1ULL << square;
-    attacks |= generateSlidingAttacks(singleBishop, occupied, friendlies, true); // Diagonals
+    attacks |= bishopAttacks(__builtin_ctzll(bishops), occupied); // Diagonals
     bishops &= bishops - 1;
   }
-  return attacks;
+
+  // Remove attacks on friendly pieces
+  return attacks & ~friendlies;
 }
 
-uint64_t Bitboards::generateRookAttacks(uint64_t rooks, uint64_t occupied, bool isWhite)
+uint64_t Bitboards::generateRookAttacks(uint64_t rooks, uint64_t occupied, bool isWhite) const
 {
   uint64_t attacks = 0;
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
 
   while (rooks)
   {
-    int square = __builtin_ctzll(rooks);
-    uint64_t singleRook = 1ULL << square;
-    attacks |= generateSlidingAttacks(singleRook, occupied, friendlies, false); // Straights
+    attacks |= rookAttacks(__builtin_ctzll(rooks), occupied); // Straights
     rooks &= rooks - 1;
   }
-  return attacks;
+
+  // Remove attacks on friendly pieces
+  return attacks & ~friendlies;
 }
 
-uint64_t Bitboards::generateQueenAttacks(uint64_t queens, uint64_t occupied, bool isWhite)
+uint64_t Bitboards::generateQueenAttacks(uint64_t queens, uint64_t occupied, bool isWhite) const
 {
   uint64_t attacks = 0;
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
 
   while (queens)
   {
-    int square = __builtin_ctzll(queens);
-    uint64_t singleQueen = 1ULL << square;
-    attacks |= generateSlidingAttacks(singleQueen, occupied, friendlies, true);  // Diagonals
-    attacks |= generateSlidingAttacks(singleQueen, occupied, friendlies, false); // Straights
+    attacks |= queenAttacks(__builtin_ctzll(queens), occupied); // Diagonals and straights
     queens &= queens - 1;
   }
-  return attacks;
+
+  // Remove attacks on friendly pieces
+  return attacks & ~friendlies;
 }
 
-uint64_t Bitboards::generateKingAttacks(uint64_t king, bool isWhite)
+uint64_t Bitboards::generateKingAttacks(uint64_t king, bool isWhite) const
 {
   uint64_t friendlies = isWhite ? whitePieces : blackPieces;
-  uint64_t attacks = 0;
-  if (king)
+  if (!king)
   {
-    int square = __builtin_ctzll(king);
-    uint64_t singleKing = 1ULL << square;
+    return 0;
+  }
 
-    uint64_t kingMoves =
-        (singleKing << 8) |
-        (singleKing >> 8) |
-        (singleKing << 1) |
-        (singleKing >> 1) |
-        (singleKing << 9) |
-        (singleKing << 7) |
-        (singleKing >> 7) |
-        (singleKing >> 9);
+  // Remove attacks on friendly pieces
+  return attacks<KING>(__builtin_ctzll(king)) & ~friendlies;
+}
 
-    // Remove attacks on friendly pieces
-    kingMoves &= ~friendlies;
+uint64_t Bitboards::attackersTo(int square, uint64_t occupied) const
+{
+  return (pawnAttacks(BLACK, square) & whitePawns) | (pawnAttacks(WHITE, square) & blackPawns) |
+         (attacks<KNIGHT>(square) & (whiteKnights | blackKnights)) |
+         (bishopAttacks(square, occupied) & (whiteBishops | blackBishops | whiteQueens | blackQueens)) |
+         (rookAttacks(square, occupied) & (whiteRooks | blackRooks | whiteQueens | blackQueens)) |
+         (attacks<KING>(square) & (whiteKings | blackKings));
+}
 
-    attacks |= kingMoves;
+uint64_t Bitboards::checkers() const
+{
+  uint64_t king = whiteToMove ? whiteKings : blackKings;
+  if (!king)
+  {
+    return 0;
   }
-  return attacks;
+  return attackersTo(__builtin_ctzll(king), whitePieces | blackPieces) & (whiteToMove ? blackPieces : whitePieces);
 }
 
 void Bitboards::printBitboards()
@@ -426,248 +518,172 @@ void Bitboards::printBitboards()
   }
 }
 
-Bitboards Bitboards::simulateMove(const Move &move)
+bool Bitboards::isConsistent() const
 {
-  Bitboards newBoard = *this;
-
-  uint64_t sourceMask = (1ULL << move.sourceSquare);
-  uint64_t targetMask = (1ULL << move.targetSquare);
-
-  // Handle captures: Remove the captured piece from its bitboard
-  if (move.isCapture)
+  uint64_t occupancy[2] = {0, 0};
+  for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++)
   {
-    if (whiteToMove)
+    if (!PieceBoards[piece])
     {
-      // Remove the captured piece from black's bitboards
-      if (newBoard.blackPawns & targetMask)
-        newBoard.blackPawns &= ~targetMask;
-      else if (newBoard.blackKnights & targetMask)
-        newBoard.blackKnights &= ~targetMask;
-      else if (newBoard.blackBishops & targetMask)
-        newBoard.blackBishops &= ~targetMask;
-      else if (newBoard.blackRooks & targetMask)
-        newBoard.blackRooks &= ~targetMask;
-      else if (newBoard.blackQueens & targetMask)
-        newBoard.blackQueens &= ~targetMask;
-      else if (newBoard.blackKings & targetMask)
-        newBoard.blackKings &= ~targetMask;
+      continue;
     }
-    else
+    uint64_t bitboard = this->*PieceBoards[piece];
+    if (bitboard & (occupancy[0] | occupancy[1]))
     {
-      // Remove the captured piece from white's bitboards
-      if (newBoard.whitePawns & targetMask)
-        newBoard.whitePawns &= ~targetMask;
-      else if (newBoard.whiteKnights & targetMask)
-        newBoard.whiteKnights &= ~targetMask;
-      else if (newBoard.whiteBishops & targetMask)
-        newBoard.whiteBishops &= ~targetMask;
-      else if (newBoard.whiteRooks & targetMask)
-        newBoard.whiteRooks &= ~targetMask;
-      else if (newBoard.whiteQueens & targetMask)
-        newBoard.whiteQueens &= ~targetMask;
-      else if (newBoard.whiteKings & targetMask)
-        newBoard.whiteKings &= ~targetMask;
+      return false; // Two pieces on one square
     }
+    occupancy[colorOf(Piece(piece))] |= bitboard;
+  }
+  if (occupancy[WHITE] != whitePieces || occupancy[BLACK] != blackPieces)
+  {
+    return false;
   }
 
-  if (move.moveType == 'O')
+  for (int square = 0; square < 64; square++)
   {
-    if (whiteToMove)
+    Piece piece = pieceAt(square);
+    uint64_t mask = 1ULL << square;
+    if (piece == NO_PIECE ? ((whitePieces | blackPieces) & mask) != 0
+                          : (PieceBoards[piece] == nullptr || !(this->*PieceBoards[piece] & mask)))
     {
-      newBoard.whiteKingCastle = false;
-      newBoard.whiteQueenCastle = false;
-      if (move.targetSquare == 62)
-      { // Kingside castling for white (e1 to g1)
-        // Move the king
-        newBoard.whiteKings &= sourceMask;
-        newBoard.whiteKings |= targetMask;
-
-        // Move the rook (h1 to f1)
-        newBoard.whiteRooks &= ~(1ULL << 63);
-        newBoard.whiteRooks |= (1ULL << 61);
-      }
-      else if (move.targetSquare == 58)
-      { // Queenside castling for white (e1 to c1)
-        // Move the king
-        newBoard.whiteKings &= sourceMask;
-        newBoard.whiteKings |= targetMask;
-
-        // Move the rook (a1 to d1)
-        newBoard.whiteRooks &= ~(1ULL << 56);
-        newBoard.whiteRooks |= (1ULL << 59);
-      }
-    }
-    else
-    {
-      newBoard.blackKingCastle = false;
-      newBoard.blackQueenCastle = false;
-      if (move.targetSquare == 2)
-      { // Kingside castling for black (e8 to g8)
-        // Move the king
-        newBoard.blackKings &= sourceMask;
-        newBoard.blackKings |= targetMask;
-
-        // Move the rook (h8 to f8)
-        newBoard.blackRooks &= ~(1ULL >> 0);
-        newBoard.blackRooks |= (1ULL >> 3);
-      }
-      else if (move.targetSquare == 6)
-      { // Queenside castling for black (e8 to c8)
-        // Move the king
-        newBoard.blackKings &= sourceMask;
-        newBoard.blackKings |= targetMask;
-
-        // Move the rook (a8 to d8)
-        newBoard.blackRooks &= ~(1ULL >> 7);
-        newBoard.blackRooks |= (1ULL >> 5);
-      }
+      return false;
     }
   }
+  return key == computeKey() && pawnKey == computePawnKey() && psqScore == computePsqScore() && phase == computePhase();
+}
 
-  // Update the moving piece
-  else if (whiteToMove)
+void castlingRookSquares(PackedMove move, int &rookSource, int &rookTarget)
+{
+  rookSource = move.flags() == KING_CASTLE ? move.sourceSquare() + 3 : move.sourceSquare() - 4;
+  rookTarget = (move.sourceSquare() + move.targetSquare()) / 2;
+}
+
+void Bitboards::makeMove(PackedMove move, UndoInfo &undo)
+{
+  undo.key = key;
+  undo.enPassantSquare = enPassantSquare;
+  undo.halfmoveClock = halfmoveClock;
+  undo.whiteKingCastle = whiteKingCastle;
+  undo.whiteQueenCastle = whiteQueenCastle;
+  undo.blackKingCastle = blackKingCastle;
+  undo.blackQueenCastle = blackQueenCastle;
+  undo.capturedPiece = NO_PIECE;
+
+  Color us = whiteToMove ? WHITE : BLACK;
+  int sourceSquare = move.sourceSquare();
+  int targetSquare = move.targetSquare();
+  Piece piece = pieceAt(sourceSquare);
+
+  if (enPassantSquare != -1)
   {
-    if (newBoard.whitePawns & (1ULL << move.sourceSquare))
-    {
-      newBoard.whitePawns &= sourceMask;
-      char c = move.moveType;
-      if (c != ' ')
-      {
-        switch (c)
-        {
-        case 'Q':
-          newBoard.whiteQueens |= targetMask;
-          break;
-        case 'N':
-          newBoard.whiteKnights |= targetMask;
-          break;
-        case 'B':
-          newBoard.whiteBishops |= targetMask;
-          break;
-        case 'R':
-          newBoard.whiteRooks |= targetMask;
-          break;
-        case 'D':
-          enPassantSquare = move.targetSquare + 8;
-        default:
-          break;
-        }
-      }
-      else
-      {
-        newBoard.whitePawns |= targetMask;
-      }
-    }
-    else if (newBoard.whiteKnights & (1ULL << move.sourceSquare))
-    {
-      newBoard.whiteKnights &= sourceMask;
-      newBoard.whiteKnights |= targetMask;
-    }
-    else if (newBoard.whiteBishops & (1ULL << move.sourceSquare))
-    {
-      newBoard.whiteBishops &= sourceMask;
-      newBoard.whiteBishops |= targetMask;
-    }
-    else if (newBoard.whiteRooks & (1ULL << move.sourceSquare))
-    {
-      newBoard.whiteRooks &= sourceMask;
-      newBoard.whiteRooks |= targetMask;
-      if (move.sourceSquare == 56)
-      {
-        newBoard.whiteQueenCastle = false;
-      }
-      else if (move.sourceSquare == 63)
-      {
-        newBoard.whiteKingCastle = false;
-      }
-    }
-    else if (newBoard.whiteQueens & (1ULL << move.sourceSquare))
-    {
-      newBoard.whiteQueens &= sourceMask;
-      newBoard.whiteQueens |= targetMask;
-    }
-    else if (newBoard.whiteKings & (1ULL << move.sourceSquare))
-    {
-      newBoard.whiteKings &= sourceMask;
-      newBoard.whiteKings |= targetMask;
-    }
+    key ^= Zobrist.enPassant[enPassantSquare % 8];
+    enPassantSquare = -1;
   }
-  else
+  halfmoveClock++;
+
+  // Remove the captured piece. An en passant capture lands on the empty square
+  // behind the pawn it takes.
+  if (move.isCapture())
   {
-    if (newBoard.blackPawns & (1ULL << move.sourceSquare))
-    {
-      newBoard.blackPawns &= sourceMask;
-      char c = move.moveType;
-      if (c != ' ')
-      {
-        switch (c)
-        {
-        case 'Q':
-          newBoard.blackQueens |= targetMask;
-          break;
-        case 'N':
-          newBoard.blackKnights |= targetMask;
-          break;
-        case 'B':
-          newBoard.blackBishops |= targetMask;
-          break;
-        case 'R':
-          newBoard.blackRooks |= targetMask;
-          break;
-        case 'D':
-          enPassantSquare = move.targetSquare - 8;
-        default:
-          break;
-        }
-      }
-      else
-      {
-        newBoard.blackPawns |= targetMask;
-      }
-    }
-    else if (newBoard.blackKnights & (1ULL << move.sourceSquare))
-    {
-      newBoard.blackKnights &= sourceMask;
-      newBoard.blackKnights |= targetMask;
-    }
-    else if (newBoard.blackBishops & (1ULL << move.sourceSquare))
-    {
-      newBoard.blackBishops &= sourceMask;
-      newBoard.blackBishops |= targetMask;
-    }
-    else if (newBoard.blackRooks & (1ULL << move.sourceSquare))
-    {
-      newBoard.blackRooks &= sourceMask;
-      newBoard.blackRooks |= targetMask;
-      if (move.sourceSquare == 0)
-      {
-        newBoard.blackQueenCastle = false;
-      }
-      else if (move.sourceSquare == 7)
-      {
-        newBoard.blackKingCastle = false;
-      }
-    }
-    else if (newBoard.blackQueens & (1ULL << move.sourceSquare))
+    int capturedSquare = move.isEnPassant() ? (whiteToMove ? targetSquare + 8 : targetSquare - 8) : targetSquare;
+    undo.capturedPiece = pieceAt(capturedSquare);
+    removePiece(capturedSquare);
+    halfmoveClock = 0;
+  }
+
+  // Move the piece itself
+  movePiece(sourceSquare, targetSquare);
+
+  if (typeOf(piece) == PAWN)
+  {
+    halfmoveClock = 0;
+    if (move.isPromotion())
     {
-      newBoard.blackQueens &= sourceMask;
-      newBoard.blackQueens |= targetMask;
+      removePiece(targetSquare);
+      putPiece(makePiece(us, move.promotionType()), targetSquare);
     }
-    else if (newBoard.blackKings & (1ULL << move.sourceSquare))
+    else if (move.flags() == DOUBLE_PUSH)
     {
-      newBoard.blackKings &= sourceMask;
-      newBoard.blackKings |= targetMask;
+      enPassantSquare = (sourceSquare + targetSquare) / 2;
+      key ^= Zobrist.enPassant[enPassantSquare % 8];
     }
   }
+  else if (move.isCastle())
+  {
+    // The king has moved; now move the rook
+    int rookSource, rookTarget;
+    castlingRookSquares(move, rookSource, rookTarget);
+    movePiece(rookSource, rookTarget);
+  }
 
-  // Update general piece bitboards
-  newBoard.whitePieces = newBoard.whitePawns | newBoard.whiteKnights | newBoard.whiteBishops |
-                         newBoard.whiteRooks | newBoard.whiteQueens | newBoard.whiteKings;
+  // Anything moving from or to a king or rook home square ends those castling rights
+  uint64_t touched = (1ULL << sourceSquare) | (1ULL << targetSquare);
+  if (touched & 0x9100000000000091ULL) // a1, e1, h1, a8, e8, h8
+  {
+    key ^= castlingKey();
+    if (touched & ((1ULL << 60) | (1ULL << 63)))
+      whiteKingCastle = false;
+    if (touched & ((1ULL << 60) | (1ULL << 56)))
+      whiteQueenCastle = false;
+    if (touched & ((1ULL << 4) | (1ULL << 7)))
+      blackKingCastle = false;
+    if (touched & ((1ULL << 4) | (1ULL << 0)))
+      blackQueenCastle = false;
+    key ^= castlingKey();
+  }
+
+  whiteToMove = !whiteToMove;
+  key ^= Zobrist.side;
+
+#ifdef BOARD_DEBUG
+  assert(isConsistent());
+#endif
+}
+
+void Bitboards::unmakeMove(PackedMove move, const UndoInfo &undo)
+{
+  whiteToMove = !whiteToMove;
+
+  Color us = whiteToMove ? WHITE : BLACK;
+  int sourceSquare = move.sourceSquare();
+  int targetSquare = move.targetSquare();
+
+  // A promoted piece turns back into the pawn that moved
+  if (move.isPromotion())
+  {
+    removePiece(targetSquare);
+    putPiece(makePiece(us, PAWN), targetSquare);
+  }
 
-  newBoard.blackPieces = newBoard.blackPawns | newBoard.blackKnights | newBoard.blackBishops |
-                         newBoard.blackRooks | newBoard.blackQueens | newBoard.blackKings;
+  movePiece(targetSquare, sourceSquare);
 
-  newBoard.whiteToMove = !whiteToMove;
+  if (move.isCastle())
+  {
+    int rookSource, rookTarget;
+    castlingRookSquares(move, rookSource, rookTarget);
+    movePiece(rookTarget, rookSource);
+  }
+
+  if (undo.capturedPiece != NO_PIECE)
+  {
+    int capturedSquare = move.isEnPassant() ? (whiteToMove ? targetSquare + 8 : targetSquare - 8) : targetSquare;
+    putPiece(undo.capturedPiece, capturedSquare);
+  }
+
+  key = undo.key;
+  enPassantSquare = undo.enPassantSquare;
+  halfmoveClock = undo.halfmoveClock;
+  whiteKingCastle = undo.whiteKingCastle;
+  whiteQueenCastle = undo.whiteQueenCastle;
+  blackKingCastle = undo.blackKingCastle;
+  blackQueenCastle = undo.blackQueenCastle;
+}
+
+Bitboards Bitboards::simulateMove(PackedMove move) const
+{
+  Bitboards newBoard = *this;
+  UndoInfo undo;
+  newBoard.makeMove(move, undo);
   return newBoard;
 }
 
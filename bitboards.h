@@ -4,23 +4,44 @@
 
 #include <cstdint>
 #include <string>
-
-class Move;
+#include "moves.h"
+#include "psqt.h"
+#include "types.h"
+#include "zobrist.h"
 
 using namespace std;
 
+// State a move destroys that unmakeMove cannot work out from the move itself
+struct UndoInfo
+{
+  uint64_t key;
+  Piece capturedPiece; // NO_PIECE for quiet moves
+  int enPassantSquare;
+  int halfmoveClock;
+  bool whiteKingCastle;
+  bool whiteQueenCastle;
+  bool blackKingCastle;
+  bool blackQueenCastle;
+};
+
 class Bitboards
 {
 public:
   uint64_t whitePawns, whiteRooks, whiteKnights, whiteBishops, whiteQueens, whiteKings;
   uint64_t blackPawns, blackRooks, blackKnights, blackBishops, blackQueens, blackKings;
   uint64_t whitePieces, blackPieces;
+  uint8_t pieceOn[64]; // Piece on each square (NO_PIECE if empty), kept in sync with the bitboards
 
   uint64_t whitePawnAttacks, whiteRookAttacks, whiteKnightAttacks, whiteBishopAttacks, whiteQueenAttacks, whiteKingAttacks;
   uint64_t blackPawnAttacks, blackRookAttacks, blackKnightAttacks, blackBishopAttacks, blackQueenAttacks, blackKingAttacks;
   uint64_t whitePieceAttacks, blackPieceAttacks;
 
+  uint64_t key;     // Zobrist key, updated incrementally by makeMove
+  uint64_t pawnKey; // Zobrist key of the pawns alone, updated likewise
+  Score psqScore; // Sum of PSQT values of all pieces (white's point of view), updated likewise
+  int phase;      // Sum of PhaseWeight over all pieces, updated likewise
   int enPassantSquare;
+  int halfmoveClock; // Plies since the last capture or pawn move
   bool whiteToMove;
 
   bool whiteKingCastle;
@@ -36,22 +57,116 @@ public:
 
   void printBitboards();
 
-  Bitboards simulateMove(const Move &move);
+  // Plays 'move' in place, updating only the bitboards it touches, and saves
+  // what unmakeMove needs in 'undo'. Attack bitboards are not refreshed.
+  void makeMove(PackedMove move, UndoInfo &undo);
+
+  // Takes back 'move', which must be the last move made with 'undo'
+  void unmakeMove(PackedMove move, const UndoInfo &undo);
+
+  // Returns a copy of the board with 'move' played
+  Bitboards simulateMove(PackedMove move) const;
 
-  uint64_t generatePawnAttacks(uint64_t pawns, bool isWhite);
-  uint64_t generateKnightAttacks(uint64_t knights, bool isWhite);
-  uint64_t generateBishopAttacks(uint64_t bishops, uint64_t occupied, bool isWhite);
-  uint64_t generateRookAttacks(uint64_t rooks, uint64_t occupied, bool isWhite);
-  uint64_t generateQueenAttacks(uint64_t queens, uint64_t occupied, bool isWhite);
-  uint64_t generateKingAttacks(uint64_t king, bool isWhite);
-  uint64_t generateSlidingAttacks(uint64_t piece, uint64_t occupied, uint64_t friendlies, bool diagonal);
+  // Piece standing on 'square', or NO_PIECE
+  Piece pieceAt(int square) const { return Piece(pieceOn[square]); }
+
+  // Zobrist key of the position computed from scratch
+  uint64_t computeKey() const;
+  uint64_t computePawnKey() const;
+
+  // psqScore and phase computed from scratch
+  Score computePsqScore() const;
+  int computePhase() const;
+
+  // Debug check that the mailbox, the occupancy sets and the incremental
+  // scores and keys agree with the piece bitboards. A full rescan, so
+  // makeMove only asserts it in builds defining BOARD_DEBUG; perftsuite
+  // always checks it.
+  bool isConsistent() const;
+
+  // Bitboard holding all pieces of kind 'piece'
+  uint64_t &pieces(Piece piece) { return this->*PieceBoards[piece]; }
+  uint64_t pieces(Piece piece) const { return this->*PieceBoards[piece]; }
+
+  // Pieces of either color attacking 'square' when the board holds 'occupied'
+  uint64_t attackersTo(int square, uint64_t occupied) const;
+
+  // Enemy pieces giving check to the side to move
+  uint64_t checkers() const;
+
+  bool inCheck() const { return checkers() != 0; }
+
+  uint64_t generatePawnAttacks(uint64_t pawns, bool isWhite) const;
+  uint64_t generateKnightAttacks(uint64_t knights, bool isWhite) const;
+  uint64_t generateBishopAttacks(uint64_t bishops, uint64_t occupied, bool isWhite) const;
+  uint64_t generateRookAttacks(uint64_t rooks, uint64_t occupied, bool isWhite) const;
+  uint64_t generateQueenAttacks(uint64_t queens, uint64_t occupied, bool isWhite) const;
+  uint64_t generateKingAttacks(uint64_t king, bool isWhite) const;
+  uint64_t generateSlidingAttacks(uint64_t piece, uint64_t occupied, uint64_t friendlies, bool diagonal) const;
   bool checkmate;
   bool stalemate;
 
 private:
+  // Member holding each Piece's bitboard, indexed by Piece
+  static uint64_t Bitboards::*const PieceBoards[16];
+
   void setBit(uint64_t &bitboard, int square);
+
+  // Low-level updates used by make/unmake; each keeps the piece bitboard,
+  // the color's occupancy set and the mailbox in sync.
+  void putPiece(Piece piece, int square)
+  {
+    uint64_t mask = 1ULL << square;
+    pieces(piece) |= mask;
+    (colorOf(piece) == WHITE ? whitePieces : blackPieces) |= mask;
+    pieceOn[square] = piece;
+    key ^= Zobrist.pieces[piece][square];
+    pawnKey ^= typeOf(piece) == PAWN ? Zobrist.pieces[piece][square] : 0;
+    psqScore += PSQT.values[piece][square];
+    phase += PhaseWeight[typeOf(piece)];
+  }
+
+  void removePiece(int square)
+  {
+    uint64_t mask = 1ULL << square;
+    Piece piece = pieceAt(square);
+    pieces(piece) &= ~mask;
+    (colorOf(piece) == WHITE ? whitePieces : blackPieces) &= ~mask;
+    pieceOn[square] = NO_PIECE;
+    key ^= Zobrist.pieces[piece][square];
+    pawnKey ^= typeOf(piece) == PAWN ? Zobrist.pieces[piece][square] : 0;
+    psqScore -= PSQT.values[piece][square];
+    phase -= PhaseWeight[typeOf(piece)];
+  }
+
+  // XOR of the castling keys for the rights currently held
+  uint64_t castlingKey() const
+  {
+    return (whiteKingCastle ? Zobrist.castling[0] : 0) ^ (whiteQueenCastle ? Zobrist.castling[1] : 0) ^
+           (blackKingCastle ? Zobrist.castling[2] : 0) ^ (blackQueenCastle ? Zobrist.castling[3] : 0);
+  }
+
+  void movePiece(int sourceSquare, int targetSquare)
+  {
+    uint64_t mask = (1ULL << sourceSquare) | (1ULL << targetSquare);
+    Piece piece = pieceAt(sourceSquare);
+    pieces(piece) ^= mask;
+    (colorOf(piece) == WHITE ? whitePieces : blackPieces) ^= mask;
+    pieceOn[sourceSquare] = NO_PIECE;
+    pieceOn[targetSquare] = piece;
+    key ^= Zobrist.pieces[piece][sourceSquare] ^ Zobrist.pieces[piece][targetSquare];
+    if (typeOf(piece) == PAWN)
+    {
+      pawnKey ^= Zobrist.pieces[piece][sourceSquare] ^ Zobrist.pieces[piece][targetSquare];
+    }
+    psqScore += PSQT.values[piece][targetSquare] - PSQT.values[piece][sourceSquare];
+  }
 };
 
 bool checks(uint64_t &bitboard);
 
+// Rook squares for a castling move: the h-file rook goes next to a king
+// landing on the g-file, the a-file rook next to one landing on the c-file.
+void castlingRookSquares(PackedMove move, int &rookSource, int &rookTarget);
+
 #endif // BITBOARDS_H
@@ -0,0 +1,42 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <string>
+#include "moves.h"
+
+class Bitboards;
+
+// Polyglot opening books (.bin): 16-byte big-endian entries (key, move,
+// weight, learn) sorted by the Polyglot hash of their position. The book
+// is mapped read-only rather than read, so loading costs the same however
+// large it is, and every engine process shares one copy of its pages.
+//
+// The Polyglot hash is built from the 781 fixed random numbers that come
+// with the format; book.cpp holds them, and the first loadBook checks them
+// against the reference hashes the format publishes.
+
+// Maps the book at 'path'. Returns false if it cannot be mapped, is not a
+// whole number of entries, or the key table fails its check.
+bool loadBook(const std::string &path);
+
+// True once a book is loaded
+bool bookLoaded();
+
+// How probeBook picks among a position's moves: the most weighted one, or
+// at random in proportion to the weights (Polyglot's own choice)
+enum BookSelection
+{
+  BOOK_BEST,
+  BOOK_WEIGHTED,
+};
+void setBookSelection(BookSelection selection);
+
+// The Polyglot hash of 'board'
+uint64_t polyglotKey(const Bitboards &board);
+
+// A book move for the side to move in 'board', or a null move if the book
+// has none that is legal here (or none is loaded)
+PackedMove probeBook(const Bitboards &board);
+
+#endif // BOOK_H
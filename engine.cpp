@@ -1,11 +1,250 @@
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cassert>
+#include "analyze.h"
+#include "attacks.h"
+#include "bench.h"
 #include "bitboards.h"
+#include "book.h"
+#include "evaluation.h"
 #include "moves.h"
+#include "nnue.h"
+#include "perft.h"
 #include "searcher.h"
+#include "tt.h"
+#include "uci.h"
 
-int main()
+static const char *StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Reads 'text' as a whole decimal number into 'value'. Otherwise prints
+// "Invalid value for <name>" and returns false.
+static bool parseNumber(const std::string &text, const std::string &name, long long &value)
+{
+  char *end;
+  errno = 0;
+  value = std::strtoll(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || errno == ERANGE)
+  {
+    std::cerr << "Invalid value for " << name << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[])
 {
+  initAttacks();
+  assert(verifyAttackTables());
+
+  // Options come first, each followed by a value:
+  //   --hash <MB>       transposition table size
+  //   --depth <plies>   search depth limit (4 if no other limit is given)
+  //   --movetime <ms>   time per move
+  //   --time <ms>, --inc <ms>  clock time and increment for the side to move
+  //   --movestogo <moves>  moves until the next time control (default: the rest of the game)
+  //   --nodes <count>   node limit
+  //   --threads <count> search threads (positions searched at once for "analyze")
+  //   --nnue <file>     loads a network and evaluates with it
+  //   --eval <classical|nnue|nnue-scalar>  evaluator; nnue-scalar avoids the SIMD kernels
+  //   --json <0|1>      search statistics as one JSON line per search
+  //   --book <file>     plays from a Polyglot book while it has moves
+  //   --book-select <best|weighted>  book move choice, weighted by default
+  SearchLimits limits = {};
+  bool json = false;
+  std::vector<std::string> args(argv + 1, argv + argc);
+  while (args.size() >= 2 && args[0].compare(0, 2, "--") == 0)
+  {
+    const std::string &option = args[0];
+    if (option == "--nnue" || option == "--eval")
+    {
+      if (option == "--nnue" && !loadNetwork(args[1]))
+      {
+        return 1;
+      }
+      std::string eval = option == "--nnue" ? "nnue" : args[1];
+      if (eval != "classical" && !networkLoaded())
+      {
+        std::cerr << "--eval " << eval << " needs a network; pass --nnue <file> first" << std::endl;
+        return 1;
+      }
+      ActiveEvaluator = eval == "classical" ? CLASSICAL_EVAL : NNUE_EVAL;
+      setNnueBackend(eval == "nnue-scalar" ? NNUE_SCALAR : NNUE_AVX2);
+      args.erase(args.begin(), args.begin() + 2);
+      continue;
+    }
+
+    if (option == "--book")
+    {
+      if (!loadBook(args[1]))
+      {
+        return 1;
+      }
+      args.erase(args.begin(), args.begin() + 2);
+      continue;
+    }
+    if (option == "--book-select")
+    {
+      setBookSelection(args[1] == "best" ? BOOK_BEST : BOOK_WEIGHTED);
+      args.erase(args.begin(), args.begin() + 2);
+      continue;
+    }
+
+    long long value;
+    if (!parseNumber(args[1], option, value))
+    {
+      return 1;
+    }
+    if (option == "--hash")
+      TT.resize(size_t(value));
+    else if (option == "--depth")
+      limits.depth = int(value);
+    else if (option == "--movetime")
+      limits.moveTimeMs = value;
+    else if (option == "--time")
+      limits.timeMs = value;
+    else if (option == "--inc")
+      limits.incrementMs = value;
+    else if (option == "--movestogo")
+      limits.movesToGo = int(value);
+    else if (option == "--nodes")
+      limits.nodes = uint64_t(value);
+    else if (option == "--threads")
+      setSearchThreads(int(value));
+    else if (option == "--json")
+      json = value != 0;
+    else
+      std::cerr << "Unknown option " << option << std::endl;
+    args.erase(args.begin(), args.begin() + 2);
+  }
+  if (!limits.depth && !limits.moveTimeMs && !limits.timeMs && !limits.nodes)
+  {
+    limits.depth = 4;
+  }
+
+  // "bench [depth]" searches the bench positions and prints the node count and speed
+  if (!args.empty() && args[0] == "bench")
+  {
+    long long depth = 6;
+    if (args.size() >= 2 && !parseNumber(args[1], "bench depth", depth))
+    {
+      return 1;
+    }
+    runBench(int(depth));
+    return 0;
+  }
+
+  // "microbench [csv]" times the individual kernels and exits
+  if (!args.empty() && args[0] == "microbench")
+  {
+    runMicroBench(args.size() >= 2 ? args[1] : "");
+    return 0;
+  }
+
+  // "smpscaling [depth] [maxThreads]" reports multi-threaded search speedup and exits
+  if (!args.empty() && args[0] == "smpscaling")
+  {
+    long long depth = 6, maxThreads = 16;
+    if ((args.size() >= 2 && !parseNumber(args[1], "smpscaling depth", depth)) ||
+        (args.size() >= 3 && !parseNumber(args[2], "smpscaling maxThreads", maxThreads)))
+    {
+      return 1;
+    }
+    runSmpScaling(int(depth), int(maxThreads));
+    return 0;
+  }
+
+  // "analyze [file]" searches every FEN in the file (or stdin) within the
+  // limits, one position per thread, prints a CSV record for each and exits
+  if (!args.empty() && args[0] == "analyze")
+  {
+    if (args.size() < 2)
+    {
+      runAnalysis(std::cin, std::cout, limits, searchThreads());
+      return 0;
+    }
+    std::ifstream file(args[1]);
+    if (!file)
+    {
+      std::cerr << "Cannot open " << args[1] << std::endl;
+      return 1;
+    }
+    runAnalysis(file, std::cout, limits, searchThreads());
+    return 0;
+  }
+
+  // "uci" speaks the UCI protocol instead of the FEN prompt
+  if (!args.empty() && args[0] == "uci")
+  {
+    uciLoop();
+    return 0;
+  }
+
+  // "nnuegen <file>" writes a network built from the piece-square tables and exits
+  if (args.size() >= 2 && args[0] == "nnuegen")
+  {
+    return writePsqNetwork(args[1]) ? 0 : 1;
+  }
+
+  // "evalbench" reports evaluations/second of each evaluator and kernel set
+  // (the NNUE ones need --nnue) and exits
+  if (!args.empty() && args[0] == "evalbench")
+  {
+    return runEvalBench() ? 0 : 1;
+  }
+
+  // "batchbench [count]" compares batch and per-position evaluation speed and exits
+  if (!args.empty() && args[0] == "batchbench")
+  {
+    long long count = 1 << 18;
+    if (args.size() >= 2 && !parseNumber(args[1], "batchbench count", count))
+    {
+      return 1;
+    }
+    return runBatchBench(size_t(count)) ? 0 : 1;
+  }
+
+  // "perftsuite" checks move generation on the reference positions and exits
+  if (!args.empty() && args[0] == "perftsuite")
+  {
+    return runPerftSuite() ? 0 : 1;
+  }
+
+  // "perft <depth> [fen]" counts move generation leaf nodes and exits;
+  // "divide <depth> [fen]" also lists the count below each root move
+  if (args.size() >= 2 && (args[0] == "perft" || args[0] == "divide"))
+  {
+    std::string fen = StartFen;
+    if (args.size() >= 3)
+    {
+      fen = args[2];
+      for (size_t i = 3; i < args.size(); i++)
+      {
+        fen += " " + args[i];
+      }
+    }
+
+    long long depth;
+    if (!parseNumber(args[1], args[0] + " depth", depth))
+    {
+      return 1;
+    }
+    Bitboards board;
+    board.initialize(fen);
+    if (args[0] == "divide")
+    {
+      divide(board, int(depth));
+    }
+    else
+    {
+      runPerft(board, int(depth));
+    }
+    return 0;
+  }
+
   // We repeatedly read a FEN, parse it, search for the best move, and print it.
   while (true)
   {
@@ -22,16 +261,21 @@ int main()
       break;
     }
 
+    // A GUI announcing itself: switch to UCI for the rest of the session
+    if (fen == "uci")
+    {
+      std::cout << std::endl;
+      uciLoop(fen);
+      break;
+    }
+
     // Initialize the board from this FEN
     Bitboards board;
     board.initialize(fen);
     board.updateAttacks(); // Make sure the attacks are up to date
 
-    // Let's pick a search depth. You can change to 4, 5, 6, etc.
-    int depth = 4;
-
     // Find the best move
-    Move bestMove = findBestMove(board, depth);
+    Move bestMove = findBestMove(board, limits);
 
     // Convert the best move to a string
     // For demonstration, we'll do something like: "e2e4" or "e7e8Q" etc.
@@ -47,6 +291,21 @@ int main()
     }
 
     std::cout << "Best move: " << moveNotation << std::endl;
+
+    // Table statistics go to stderr so the move output stays unchanged
+    const SearchStats &stats = lastSearchStats();
+    if (json)
+    {
+      std::cerr << searchStatsJson(stats) << std::endl;
+      continue;
+    }
+    std::cerr << "depth " << stats.depth << " time " << stats.elapsedMs << "ms"
+              << " nodes " << stats.nodes << " tt hits " << stats.ttHits << "/" << stats.ttProbes
+              << " (" << (stats.ttProbes ? 100.0 * stats.ttHits / stats.ttProbes : 0.0) << "%)"
+              << " cutoffs " << stats.ttCutoffs << " hashfull " << TT.hashfull()
+              << " first-move cutoffs " << (stats.betaCutoffs ? 100.0 * stats.firstMoveCutoffs / stats.betaCutoffs : 0.0)
+              << "% pawn hash hits " << (stats.pawnProbes ? 100.0 * stats.pawnHits / stats.pawnProbes : 0.0)
+              << "%" << std::endl;
   }
 
   return 0;
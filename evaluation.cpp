@@ -1,145 +1,38 @@
 #include "bitboards.h"
 #include "evaluation.h"
-#include "moves.h"
+#include "pawns.h"
 
-#include <iostream>
+Evaluator ActiveEvaluator = CLASSICAL_EVAL;
 
-using namespace std;
-
-static const double WhitePawnPSQ[64] = {
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    1.3, 1.3, 1.3, 1.3, 1.3, 1.3, 1.3, 1.3,
-    1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2,
-    1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2,
-    1.1, 1.1, 1.2, 1.2, 1.2, 1.2, 1.1, 1.1,
-    1.1, 1.1, 1.1, 1.1, 1.1, 1.1, 1.1, 1.1,
-    1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0,
-    0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-
-static const double BlackPawnPSQ[64] = {
-    0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
-    1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0,
-    1.1, 1.1, 1.1, 1.1, 1.1, 1.1, 1.1, 1.1,
-    1.1, 1.1, 1.2, 1.2, 1.2, 1.2, 1.1, 1.1,
-    1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2,
-    1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2, 1.2,
-    1.3, 1.3, 1.3, 1.3, 1.3, 1.3, 1.3, 1.3,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0};
-
-static const double WhiteKnightPSQ[64] = {
-    2.5, 2.5, 2.7, 2.7, 2.7, 2.7, 2.5, 2.5,
-    2.5, 2.7, 3.0, 3.0, 3.0, 3.0, 2.7, 2.5,
-    2.7, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 2.7,
-    3.0, 3.0, 3.0, 3.3, 3.3, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.3, 3.3, 3.0, 3.0, 3.0,
-    2.7, 3.0, 3.3, 3.0, 3.0, 3.3, 3.0, 2.7,
-    2.5, 2.7, 3.0, 3.0, 3.0, 3.0, 2.7, 2.5,
-    2.5, 2.5, 2.7, 2.7, 2.7, 2.7, 2.5, 2.5};
-
-static const double BlackKnightPSQ[64] = {
-    2.5, 2.5, 2.7, 2.7, 2.7, 2.7, 2.5, 2.5,
-    2.5, 2.7, 3.0, 3.0, 3.0, 3.0, 2.7, 2.5,
-    2.7, 3.0, 3.3, 3.0, 3.0, 3.3, 3.0, 2.7,
-    3.0, 3.0, 3.0, 3.3, 3.3, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.3, 3.3, 3.0, 3.0, 3.0,
-    2.7, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 2.7,
-    2.5, 2.7, 3.0, 3.0, 3.0, 3.0, 2.7, 2.5,
-    2.5, 2.5, 2.7, 2.7, 2.7, 2.7, 2.5, 2.5};
-
-static const double WhiteBishopPSQ[64] = {
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.2, 3.0, 3.0, 3.0, 3.0, 3.2, 3.0,
-    3.0, 3.0, 3.2, 3.0, 3.0, 3.2, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.2, 3.0, 3.0, 3.0, 3.0, 3.2, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0};
-
-static const double BlackBishopPSQ[64] = {
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.2, 3.0, 3.0, 3.0, 3.0, 3.2, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.2, 3.0, 3.0, 3.2, 3.0, 3.0,
-    3.0, 3.2, 3.0, 3.0, 3.0, 3.0, 3.2, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0,
-    3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0};
-
-static const double WhiteRookPSQ[64] = {
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0};
-
-static const double BlackRookPSQ[64] = {
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0,
-    5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0};
-
-static const double WhiteQueenPSQ[64] = {
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0};
-
-static const double BlackQueenPSQ[64] = {
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0,
-    9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0, 9.0};
-
-double pieceEvaluation(uint64_t bitboard, const double PSQ[64], std::string temp)
+Score pieceEvaluation(uint64_t bitboard, const Score PSQ[64])
 {
-    double value = 0.0;
-    int square = 0;
+    Score value = 0;
 
     while (bitboard)
     {
-        if (bitboard & 1ULL)
-        {
-            value += PSQ[square];
-        }
-
-        bitboard >>= 1;
-        square++;
+        value += PSQ[__builtin_ctzll(bitboard)];
+        bitboard &= bitboard - 1;
     }
 
     return value;
 }
 
-double evaluateBoard(Bitboards bitboards)
+// Promotions can push the phase past its starting value
+int taper(Score score, int phase)
 {
-    double value = 0.0;
-
-    value += pieceEvaluation(bitboards.whitePawns, WhitePawnPSQ, "wp");
-    value += pieceEvaluation(bitboards.whiteKnights, WhiteKnightPSQ, "wk");
-    value += pieceEvaluation(bitboards.whiteBishops, WhiteBishopPSQ, "wb");
-    value += pieceEvaluation(bitboards.whiteRooks, WhiteRookPSQ, "wr");
-    value += pieceEvaluation(bitboards.whiteQueens, WhiteQueenPSQ, "wq");
+    phase = phase < MaxPhase ? phase : MaxPhase;
+    return (mgValue(score) * phase + egValue(score) * (MaxPhase - phase)) / MaxPhase;
+}
 
-    value -= pieceEvaluation(bitboards.blackPawns, BlackPawnPSQ, "bp");
-    value -= pieceEvaluation(bitboards.blackKnights, BlackKnightPSQ, "bk");
-    value -= pieceEvaluation(bitboards.blackBishops, BlackBishopPSQ, "bb");
-    value -= pieceEvaluation(bitboards.blackRooks, BlackRookPSQ, "br");
-    value -= pieceEvaluation(bitboards.blackQueens, BlackQueenPSQ, "bq");
+int evaluateBoard(const Bitboards &board, PawnTable &pawns)
+{
+    // Material and piece-square values are kept up to date by makeMove
+    Score score = board.psqScore + pawns.probe(board) + evaluatePawnShield(board);
+    return taper(score, board.phase);
+}
 
-    return value;
-}
\ No newline at end of file
+int evaluateBoard(const Bitboards &board)
+{
+    Score score = board.psqScore + evaluatePawns(board.whitePawns, board.blackPawns) + evaluatePawnShield(board);
+    return taper(score, board.phase);
+}
@@ -3,25 +3,30 @@
 #define EVALUATION_H
 
 #include <cstdint>
+#include "psqt.h"
+#include "types.h"
 
-enum PieceType
-{
-  PAWN,
-  KNIGHT,
-  BISHOP,
-  ROOK,
-  QUEEN,
-  KING,
-};
+class Bitboards;
+class PawnTable;
 
-enum Color
+// Which evaluation the search uses. NNUE needs a network loaded first.
+enum Evaluator
 {
-  WHITE,
-  BLACK,
+  CLASSICAL_EVAL, // Tapered piece-square tables and pawn structure
+  NNUE_EVAL,      // The network in nnue.h
 };
 
-double pieceEvaluation(uint64_t bitboard, const double PSQ[64]);
+extern Evaluator ActiveEvaluator;
+
+// Sum of PSQ over the squares set in 'bitboard'
+Score pieceEvaluation(uint64_t bitboard, const Score PSQ[64]);
+
+// Blends the middlegame and endgame halves of 'score' by the game phase
+int taper(Score score, int phase);
 
-double evaluateBoard(Bitboards bitboard);
+// Static evaluation in centipawns from white's point of view. The pawn
+// structure term is looked up in 'pawns' when given, else computed.
+int evaluateBoard(const Bitboards &board, PawnTable &pawns);
+int evaluateBoard(const Bitboards &board);
 
 #endif
@@ -0,0 +1,66 @@
+#include "filemap.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void unmapFile(FileMapping &m)
+{
+#ifdef _WIN32
+  if (m.data)
+    UnmapViewOfFile(m.data);
+  if (m.mapping)
+    CloseHandle(m.mapping);
+  if (m.file)
+    CloseHandle(m.file);
+#else
+  if (m.data)
+    munmap(const_cast<char *>(m.data), m.size);
+#endif
+  m = FileMapping();
+}
+
+bool mapFile(const std::string &path, FileMapping &m)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  m.file = file == INVALID_HANDLE_VALUE ? nullptr : file;
+  LARGE_INTEGER size;
+  if (!m.file || !GetFileSizeEx(m.file, &size) || size.QuadPart == 0)
+  {
+    unmapFile(m);
+    return false;
+  }
+  m.size = size_t(size.QuadPart);
+  m.mapping = CreateFileMappingA(m.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  m.data = m.mapping ? static_cast<const char *>(MapViewOfFile(m.mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    m.size = size_t(st.st_size);
+    void *data = mmap(nullptr, m.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    m.data = data == MAP_FAILED ? nullptr : static_cast<const char *>(data);
+  }
+  close(fd); // The mapping stays valid without the descriptor
+#endif
+  if (!m.data)
+  {
+    unmapFile(m);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,26 @@
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+#include <cstddef>
+#include <string>
+
+// A read-only view of a whole file. The pages are shared with every other
+// process mapping the same file, and only those touched are read from disk.
+struct FileMapping
+{
+  const char *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void *file = nullptr; // HANDLEs, kept out of this header's includes
+  void *mapping = nullptr;
+#endif
+};
+
+// Maps the file at 'path' into 'm'. Returns false, leaving 'm' empty, if it
+// cannot be opened or is empty.
+bool mapFile(const std::string &path, FileMapping &m);
+
+// Releases the view, if any, and empties 'm'
+void unmapFile(FileMapping &m);
+
+#endif // FILEMAP_H
@@ -0,0 +1,239 @@
+#include "movepick.h"
+#include "attacks.h"
+#include "bitboards.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+  // Exchange values in centipawns, by PieceType. The king is worth more
+  // than everything else together, so it only ever captures last.
+  const int SeeValue[7] = {0, 100, 300, 300, 500, 900, 20000};
+
+  // Cheapest piece of 'color' among 'attackers'; sets 'square' to where it stands
+  PieceType leastValuableAttacker(const Bitboards &board, uint64_t attackers, Color color, int &square)
+  {
+    for (int type = PAWN; type <= KING; type++)
+    {
+      uint64_t pieces = attackers & board.pieces(makePiece(color, PieceType(type)));
+      if (pieces)
+      {
+        square = __builtin_ctzll(pieces);
+        return PieceType(type);
+      }
+    }
+    return NO_PIECE_TYPE;
+  }
+}
+
+int mvvLva(const Bitboards &board, PackedMove move)
+{
+  PieceType victim = move.isEnPassant() ? PAWN : typeOf(board.pieceAt(move.targetSquare()));
+  PieceType attacker = typeOf(board.pieceAt(move.sourceSquare()));
+  int score = victim * 8 - attacker;
+  if (move.isPromotion())
+  {
+    score += move.promotionType() * 8;
+  }
+  return score;
+}
+
+int staticExchange(const Bitboards &board, PackedMove move)
+{
+  if (move.isCastle())
+  {
+    return 0;
+  }
+
+  int sourceSquare = move.sourceSquare();
+  int targetSquare = move.targetSquare();
+  Color us = colorOf(board.pieceAt(sourceSquare));
+  PieceType moving = move.isPromotion() ? move.promotionType() : typeOf(board.pieceAt(sourceSquare));
+
+  // gain[d] is what the side making capture d wins if the exchange stops there
+  int gain[32];
+  gain[0] = move.isEnPassant() ? SeeValue[PAWN] : SeeValue[typeOf(board.pieceAt(targetSquare))];
+  if (move.isPromotion())
+  {
+    gain[0] += SeeValue[moving] - SeeValue[PAWN];
+  }
+
+  uint64_t occupied = (board.whitePieces | board.blackPieces) ^ (1ULL << sourceSquare);
+  if (move.isEnPassant())
+  {
+    occupied ^= 1ULL << (us == WHITE ? targetSquare + 8 : targetSquare - 8);
+  }
+
+  uint64_t diagonalSliders = board.whiteBishops | board.blackBishops | board.whiteQueens | board.blackQueens;
+  uint64_t straightSliders = board.whiteRooks | board.blackRooks | board.whiteQueens | board.blackQueens;
+  uint64_t attackers = board.attackersTo(targetSquare, occupied) & occupied;
+
+  Color side = us == WHITE ? BLACK : WHITE;
+  int depth = 0;
+  while (depth < 31)
+  {
+    int square;
+    PieceType attacker = leastValuableAttacker(board, attackers & occupied, side, square);
+    if (attacker == NO_PIECE_TYPE)
+    {
+      break;
+    }
+
+    // Capture the piece that took last
+    depth++;
+    gain[depth] = SeeValue[moving] - gain[depth - 1];
+    moving = attacker;
+
+    // Neither side would continue if both outcomes lose for the side to capture
+    if (std::max(-gain[depth - 1], gain[depth]) < 0)
+    {
+      break;
+    }
+
+    // Sliders behind the capturing piece join in
+    occupied ^= 1ULL << square;
+    attackers |= (bishopAttacks(targetSquare, occupied) & diagonalSliders) |
+                 (rookAttacks(targetSquare, occupied) & straightSliders);
+    side = side == WHITE ? BLACK : WHITE;
+  }
+
+  // Each side picks the better of recapturing or stopping, from the end back
+  while (depth > 0)
+  {
+    gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    depth--;
+  }
+  return gain[0];
+}
+
+MovePicker::MovePicker(const Bitboards &board, PackedMove hashMove, const PackedMove (&killers)[2],
+                       const int (&history)[64][64], int variation)
+    : board(board), hashMove(hashMove), killers{killers[0], killers[1]}, history(history),
+      variation(variation), stage(HASH_MOVE), current(0), badCurrent(0)
+{
+  if (!isLegalMove(board, hashMove))
+  {
+    this->hashMove = PackedMove();
+  }
+}
+
+bool MovePicker::isSpecial(PackedMove move) const
+{
+  return move == hashMove || move == killers[0] || move == killers[1];
+}
+
+PackedMove MovePicker::pickBest()
+{
+  size_t best = current;
+  for (size_t i = current + 1; i < moves.size(); i++)
+  {
+    if (scores[i] > scores[best])
+    {
+      best = i;
+    }
+  }
+  std::swap(moves[current], moves[best]);
+  std::swap(scores[current], scores[best]);
+  return moves[current++];
+}
+
+PackedMove MovePicker::next()
+{
+  switch (stage)
+  {
+  case HASH_MOVE:
+    stage = GENERATE_CAPTURES;
+    if (!hashMove.isNull())
+    {
+      return hashMove;
+    }
+    [[fallthrough]];
+
+  case GENERATE_CAPTURES:
+    moves = generateCaptures(board, board.whiteToMove);
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+      scores[i] = mvvLva(board, moves[i]);
+    }
+    current = 0;
+    stage = GOOD_CAPTURES;
+    [[fallthrough]];
+
+  case GOOD_CAPTURES:
+    while (current < moves.size())
+    {
+      PackedMove move = pickBest();
+      if (move == hashMove)
+      {
+        continue;
+      }
+      // Losing captures wait until after the quiet moves
+      if (staticExchange(board, move) < 0)
+      {
+        badCaptures.push_back(move);
+        continue;
+      }
+      return move;
+    }
+    stage = FIRST_KILLER;
+    [[fallthrough]];
+
+  case FIRST_KILLER:
+  case SECOND_KILLER:
+    while (stage != GENERATE_QUIETS)
+    {
+      PackedMove killer = killers[stage == FIRST_KILLER ? 0 : 1];
+      stage = Stage(stage + 1);
+      // Killers are quiet moves from sibling nodes and may not be legal here
+      if (!killer.isNull() && killer != hashMove && !killer.isCapture() && !killer.isPromotion() &&
+          isLegalMove(board, killer))
+      {
+        return killer;
+      }
+    }
+    [[fallthrough]];
+
+  case GENERATE_QUIETS:
+  {
+    MoveList quiets = generateQuiets(board, board.whiteToMove);
+    moves.clear();
+    for (PackedMove move : quiets)
+    {
+      if (!isSpecial(move))
+      {
+        int from = move.sourceSquare(), to = move.targetSquare();
+        scores[moves.size()] = history[from][to];
+        if (variation)
+        {
+          // 0..15 from a hash of the move and the variation
+          scores[moves.size()] += int(uint32_t((from * 64 + to) ^ (variation << 12)) * 2654435761u >> 28);
+        }
+        moves.push_back(move);
+      }
+    }
+    current = 0;
+    stage = QUIETS;
+  }
+    [[fallthrough]];
+
+  case QUIETS:
+    if (current < moves.size())
+    {
+      return pickBest();
+    }
+    stage = BAD_CAPTURES;
+    [[fallthrough]];
+
+  case BAD_CAPTURES:
+    if (badCurrent < badCaptures.size())
+    {
+      return badCaptures[badCurrent++];
+    }
+    stage = DONE;
+    [[fallthrough]];
+
+  case DONE:
+    break;
+  }
+  return PackedMove();
+}
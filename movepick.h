@@ -0,0 +1,72 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "moves.h"
+
+class Bitboards;
+
+// Most Valuable Victim - Least Valuable Attacker: captures of big pieces
+// first, and among those the cheapest attacker first. Promotions add the
+// promoted piece.
+int mvvLva(const Bitboards &board, PackedMove move);
+
+// Static exchange evaluation: material (in centipawns) the side to move
+// wins if both sides keep recapturing on the target square with their
+// cheapest attacker, each stopping when that would lose more.
+int staticExchange(const Bitboards &board, PackedMove move);
+
+// Hands out the legal moves of a position one at a time, best guesses
+// first. Each group is generated only once the ones before it are used up,
+// so a cutoff on an early move skips generating the rest:
+//   1. the hash move
+//   2. captures and promotions that do not lose material, by MVV-LVA
+//   3. the two killer moves of this ply
+//   4. quiet moves by history
+//   5. captures that lose material, by MVV-LVA
+// A nonzero 'variation' (a helper thread's id) adds a small bias of its own
+// to each quiet move's history score, so helpers searching the same
+// position try equally or closely scored quiets in different orders.
+class MovePicker
+{
+public:
+  MovePicker(const Bitboards &board, PackedMove hashMove, const PackedMove (&killers)[2],
+             const int (&history)[64][64], int variation = 0);
+
+  // The next move, or a null move once every move has been returned
+  PackedMove next();
+
+private:
+  enum Stage
+  {
+    HASH_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    FIRST_KILLER,
+    SECOND_KILLER,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    DONE,
+  };
+
+  // Removes and returns the highest scored of the remaining moves
+  PackedMove pickBest();
+
+  // True if the move was already returned by an earlier stage
+  bool isSpecial(PackedMove move) const;
+
+  const Bitboards &board;
+  PackedMove hashMove;
+  PackedMove killers[2];
+  const int (&history)[64][64];
+  int variation;
+
+  Stage stage;
+  MoveList moves; // Moves of the current stage
+  int scores[MoveList::Capacity];
+  size_t current;
+  MoveList badCaptures;
+  size_t badCurrent;
+};
+
+#endif // MOVEPICK_H
@@ -1,8 +1,96 @@
 #include "moves.h"
 #include "bitboards.h"
+#include "attacks.h"
+#include <cctype>
 #include <iostream>
 
-void generatePawnMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+// Adds all four promotions; 'flags' is CAPTURE for capturing promotions
+static void addPromotions(MoveList &moves, int sourceSquare, int targetSquare, int flags)
+{
+  moves.push_back(PackedMove(sourceSquare, targetSquare, flags | QUEEN_PROMOTION));
+  moves.push_back(PackedMove(sourceSquare, targetSquare, flags | KNIGHT_PROMOTION));
+  moves.push_back(PackedMove(sourceSquare, targetSquare, flags | ROOK_PROMOTION));
+  moves.push_back(PackedMove(sourceSquare, targetSquare, flags | BISHOP_PROMOTION));
+}
+
+// A pinned piece may only move along the line through its king and the pinner
+static bool staysOnPin(const MoveMasks &masks, int sourceSquare, int targetSquare)
+{
+  return !(masks.pinned & (1ULL << sourceSquare)) ||
+         (LineThrough[masks.kingSquare][sourceSquare] & (1ULL << targetSquare));
+}
+
+// Squares a knight, slider or king may move to as far as the mode is
+// concerned; legality still has to be checked for the king and pins
+static uint64_t modeTargets(const Bitboards &board, bool isWhite, const MoveMasks &masks, uint64_t targets)
+{
+  uint64_t enemies = isWhite ? board.blackPieces : board.whitePieces;
+  return masks.capturesOnly ? targets & enemies : masks.quietsOnly ? targets & ~enemies : targets;
+}
+
+// True if no enemy piece would attack 'square' with the board holding 'occupied'.
+// 'ignored' removes pieces that are captured in the hypothetical position.
+static bool isSafe(const Bitboards &board, bool isWhite, int square, uint64_t occupied, uint64_t ignored = 0)
+{
+  uint64_t enemies = (isWhite ? board.blackPieces : board.whitePieces) & ~ignored;
+  return !(board.attackersTo(square, occupied) & enemies);
+}
+
+MoveMasks computeMoveMasks(const Bitboards &board, bool isWhite, bool capturesOnly, bool quietsOnly)
+{
+  MoveMasks masks;
+  uint64_t king = isWhite ? board.whiteKings : board.blackKings;
+  uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
+  uint64_t enemies = isWhite ? board.blackPieces : board.whitePieces;
+  uint64_t occupied = friendlies | enemies;
+
+  masks.checkers = 0;
+  masks.pinned = 0;
+  masks.targets = ~friendlies;
+  masks.kingSquare = king ? __builtin_ctzll(king) : -1;
+  masks.capturesOnly = capturesOnly;
+  masks.quietsOnly = quietsOnly;
+  if (!king)
+  {
+    return masks;
+  }
+
+  int kingSquare = masks.kingSquare;
+  masks.checkers = board.attackersTo(kingSquare, occupied) & enemies;
+
+  // Enemy sliders lined up with the king pin the only piece between them, if it is ours
+  uint64_t enemyQueens = isWhite ? board.blackQueens : board.whiteQueens;
+  uint64_t enemyDiagonal = (isWhite ? board.blackBishops : board.whiteBishops) | enemyQueens;
+  uint64_t enemyStraight = (isWhite ? board.blackRooks : board.whiteRooks) | enemyQueens;
+  uint64_t snipers = (bishopAttacks(kingSquare, 0) & enemyDiagonal) | (rookAttacks(kingSquare, 0) & enemyStraight);
+  while (snipers)
+  {
+    uint64_t blockers = BetweenSquares[kingSquare][__builtin_ctzll(snipers)] & occupied;
+    if (blockers && !(blockers & (blockers - 1)))
+    {
+      masks.pinned |= blockers & friendlies;
+    }
+    snipers &= snipers - 1;
+  }
+
+  // In check, a non-king move must capture the checker or step between it
+  // and the king. In double check only the king may move.
+  if (masks.checkers)
+  {
+    if (masks.checkers & (masks.checkers - 1))
+    {
+      masks.targets = 0;
+    }
+    else
+    {
+      int checkerSquare = __builtin_ctzll(masks.checkers);
+      masks.targets = masks.checkers | BetweenSquares[kingSquare][checkerSquare];
+    }
+  }
+  return masks;
+}
+
+void generatePawnMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t pawns = isWhite ? board.whitePawns : board.blackPawns;
   uint64_t opponentPieces = isWhite ? board.blackPieces : board.whitePieces;
@@ -16,28 +104,44 @@ void generatePawnMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
                             ? (((singlePush >> 8) & emptySquares) & 0x00000000FF00000000ULL)  // White pawns on rank 2
                             : (((singlePush << 8) & emptySquares) & 0x0000000000FF000000ULL); // Black pawns on rank 7
 
+  // Only pushes that block a check are left when in check. Pushes are never
+  // captures, so the captures-only mode keeps just the promotions and the
+  // quiets-only mode everything else.
+  singlePush &= masks.targets;
+  doublePush &= masks.targets;
+  uint64_t promotionRank = isWhite ? 0x00000000000000FFULL : 0xFF00000000000000ULL;
+  if (masks.capturesOnly)
+  {
+    singlePush &= promotionRank;
+    doublePush = 0;
+  }
+  else if (masks.quietsOnly)
+  {
+    singlePush &= ~promotionRank;
+  }
+
   // Add single pushes
   while (singlePush)
   {
     int targetSquare = __builtin_ctzll(singlePush);                   // Target square index
     int sourceSquare = isWhite ? targetSquare + 8 : targetSquare - 8; // Source square index
+    singlePush &= singlePush - 1;                                     // Remove the processed bit
 
-    // Promotion check
-    if (targetSquare / 8 == (isWhite ? 7 : 0))
+    if (!staysOnPin(masks, sourceSquare, targetSquare))
     {
-      // Add promotion moves
-      moves.push_back({sourceSquare, targetSquare, 'Q', false});
-      moves.push_back({sourceSquare, targetSquare, 'N', false});
-      moves.push_back({sourceSquare, targetSquare, 'R', false});
-      moves.push_back({sourceSquare, targetSquare, 'B', false});
+      continue;
+    }
+
+    // Promotion check (row 0 is rank 8)
+    if (targetSquare / 8 == (isWhite ? 0 : 7))
+    {
+      addPromotions(moves, sourceSquare, targetSquare, QUIET_MOVE);
     }
     else
     {
       // Regular single push
-      moves.push_back({sourceSquare, targetSquare, ' ', false});
+      moves.push_back(PackedMove(sourceSquare, targetSquare, QUIET_MOVE));
     }
-
-    singlePush &= singlePush - 1; // Remove the processed bit
   }
 
   // Add double pushes
@@ -46,110 +150,152 @@ void generatePawnMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
     int targetSquare = __builtin_ctzll(doublePush);                     // Target square index
     int sourceSquare = isWhite ? targetSquare + 16 : targetSquare - 16; // Source square index
 
-    moves.push_back({sourceSquare, targetSquare, 'D', false});
+    if (staysOnPin(masks, sourceSquare, targetSquare))
+    {
+      moves.push_back(PackedMove(sourceSquare, targetSquare, DOUBLE_PUSH));
+    }
     doublePush &= doublePush - 1; // Remove the processed bit
   }
 
+  if (masks.quietsOnly)
+  {
+    return;
+  }
+
   // Add captures (diagonal attacks)
   uint64_t attacks = isWhite ? board.generatePawnAttacks(pawns, true)
                              : board.generatePawnAttacks(pawns, false);
-  uint64_t captures = attacks & opponentPieces;
+  uint64_t captures = attacks & opponentPieces & masks.targets;
+  Color them = isWhite ? BLACK : WHITE;
   while (captures)
   {
     int targetSquare = __builtin_ctzll(captures); // Target square index
-    uint64_t sourceMask = isWhite
-                              ? ((pawns & ((1ULL << targetSquare) >> 7)) ? ((1ULL << targetSquare) >> 7) : ((1ULL << targetSquare) >> 9))
-                              : ((pawns & ((1ULL << targetSquare) << 7)) ? ((1ULL << targetSquare) << 7) : ((1ULL << targetSquare) << 9));
-    int sourceSquare = __builtin_ctzll(sourceMask); // Source square index
 
-    moves.push_back({sourceSquare, targetSquare, ' ', true});
+    // Our pawns attacking the target stand where an enemy pawn on the target would attack
+    uint64_t sources = pawns & pawnAttacks(them, targetSquare);
+    while (sources)
+    {
+      int sourceSquare = __builtin_ctzll(sources); // Source square index
+      sources &= sources - 1;
+      if (!staysOnPin(masks, sourceSquare, targetSquare))
+      {
+        continue;
+      }
+      if (targetSquare / 8 == (isWhite ? 0 : 7))
+      {
+        addPromotions(moves, sourceSquare, targetSquare, CAPTURE);
+      }
+      else
+      {
+        moves.push_back(PackedMove(sourceSquare, targetSquare, CAPTURE));
+      }
+    }
     captures &= captures - 1; // Remove the processed bit
   }
 
   if (board.enPassantSquare != -1)
   {
-    uint64_t enPassantMask = 1ULL << board.enPassantSquare;
-    uint64_t enPassantPawns = isWhite
-                                  ? ((pawns & ((enPassantMask << 7) | (enPassantMask << 9))) & ~0x0101010101010101ULL & ~0x8080808080808080ULL)
-                                  : ((pawns & ((enPassantMask >> 7) | (enPassantMask >> 9))) & ~0x0101010101010101ULL & ~0x8080808080808080ULL);
+    uint64_t enPassantPawns = pawns & pawnAttacks(them, board.enPassantSquare);
+    int capturedSquare = isWhite ? board.enPassantSquare + 8 : board.enPassantSquare - 8;
 
     while (enPassantPawns)
     {
       int sourceSquare = __builtin_ctzll(enPassantPawns);
-      moves.push_back({sourceSquare, board.enPassantSquare, ' ', true});
       enPassantPawns &= enPassantPawns - 1;
+
+      // Two pawns leave the capturing pawn's rank at once, which can uncover a
+      // slider the pin masks do not see, so the resulting position is tested
+      // directly. This also covers evading a check from the pushed pawn.
+      uint64_t occupied = (board.whitePieces | board.blackPieces) ^ (1ULL << sourceSquare) ^
+                          (1ULL << capturedSquare) ^ (1ULL << board.enPassantSquare);
+      if (masks.kingSquare == -1 ||
+          isSafe(board, isWhite, masks.kingSquare, occupied, 1ULL << capturedSquare))
+      {
+        moves.push_back(PackedMove(sourceSquare, board.enPassantSquare, EN_PASSANT));
+      }
     }
   }
 }
 
-void generateKnightMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+void generateKnightMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t knights = isWhite ? board.whiteKnights : board.blackKnights;
-  uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
 
   while (knights)
   {
     int sourceSquare = __builtin_ctzll(knights);
-    uint64_t attacks = board.generateKnightAttacks(1ULL << sourceSquare, isWhite) & ~friendlies;
+    uint64_t targets = modeTargets(board, isWhite, masks, attacks<KNIGHT>(sourceSquare) & masks.targets);
 
-    while (attacks)
+    // A pinned knight can never stay on the pin line
+    if (masks.pinned & (1ULL << sourceSquare))
     {
-      int targetSquare = __builtin_ctzll(attacks);
-      bool isCapture = ((1ULL << targetSquare) & (isWhite ? board.blackPieces : board.whitePieces));
-      moves.push_back({sourceSquare, targetSquare, ' ', isCapture});
-      attacks &= attacks - 1;
+      targets = 0;
+    }
+
+    while (targets)
+    {
+      int targetSquare = __builtin_ctzll(targets);
+      bool isCapture = board.pieceAt(targetSquare) != NO_PIECE; // Friendly squares are already masked out
+      moves.push_back(PackedMove(sourceSquare, targetSquare, isCapture ? CAPTURE : QUIET_MOVE));
+      targets &= targets - 1;
     }
     knights &= knights - 1;
   }
 }
 
-void generateBishopMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+void generateBishopMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t bishops = isWhite ? board.whiteBishops : board.blackBishops;
-  uint64_t attacks = isWhite ? board.generateBishopAttacks(bishops, board.whitePieces | board.blackPieces, true)
-                             : board.generateBishopAttacks(bishops, board.whitePieces | board.blackPieces, false);
   uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
 
   while (bishops)
   {
     int sourceSquare = __builtin_ctzll(bishops);
     uint64_t pieceAttacks = board.generateBishopAttacks(1ULL << sourceSquare, board.whitePieces | board.blackPieces, isWhite) & ~friendlies;
+    pieceAttacks = modeTargets(board, isWhite, masks, pieceAttacks & masks.targets);
+    if (masks.pinned & (1ULL << sourceSquare))
+    {
+      pieceAttacks &= LineThrough[masks.kingSquare][sourceSquare];
+    }
 
     while (pieceAttacks)
     {
       int targetSquare = __builtin_ctzll(pieceAttacks);
-      bool isCapture = ((1ULL << targetSquare) & (isWhite ? board.blackPieces : board.whitePieces));
-      moves.push_back({sourceSquare, targetSquare, ' ', isCapture});
+      bool isCapture = board.pieceAt(targetSquare) != NO_PIECE; // Friendly squares are already masked out
+      moves.push_back(PackedMove(sourceSquare, targetSquare, isCapture ? CAPTURE : QUIET_MOVE));
       pieceAttacks &= pieceAttacks - 1;
     }
     bishops &= bishops - 1;
   }
 }
 
-void generateRookMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+void generateRookMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t rooks = isWhite ? board.whiteRooks : board.blackRooks;
-  uint64_t attacks = isWhite ? board.generateRookAttacks(rooks, board.whitePieces | board.blackPieces, true)
-                             : board.generateRookAttacks(rooks, board.whitePieces | board.blackPieces, false);
   uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
 
   while (rooks)
   {
     int sourceSquare = __builtin_ctzll(rooks);
     uint64_t pieceAttacks = board.generateRookAttacks(1ULL << sourceSquare, board.whitePieces | board.blackPieces, isWhite) & ~friendlies;
+    pieceAttacks = modeTargets(board, isWhite, masks, pieceAttacks & masks.targets);
+    if (masks.pinned & (1ULL << sourceSquare))
+    {
+      pieceAttacks &= LineThrough[masks.kingSquare][sourceSquare];
+    }
 
     while (pieceAttacks)
     {
       int targetSquare = __builtin_ctzll(pieceAttacks);
-      bool isCapture = ((1ULL << targetSquare) & (isWhite ? board.blackPieces : board.whitePieces));
-      moves.push_back({sourceSquare, targetSquare, ' ', isCapture});
+      bool isCapture = board.pieceAt(targetSquare) != NO_PIECE; // Friendly squares are already masked out
+      moves.push_back(PackedMove(sourceSquare, targetSquare, isCapture ? CAPTURE : QUIET_MOVE));
       pieceAttacks &= pieceAttacks - 1;
     }
     rooks &= rooks - 1;
   }
 }
 
-void generateQueenMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+void generateQueenMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t queens = isWhite ? board.whiteQueens : board.blackQueens;
   uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
@@ -161,87 +307,176 @@ void generateQueenMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
     uint64_t straightAttacks = board.generateRookAttacks(1ULL << sourceSquare, board.whitePieces | board.blackPieces, isWhite) & ~friendlies;
 
     // Combine diagonal and straight attacks
-    uint64_t pieceAttacks = diagonalAttacks | straightAttacks;
+    uint64_t pieceAttacks = modeTargets(board, isWhite, masks, (diagonalAttacks | straightAttacks) & masks.targets);
+    if (masks.pinned & (1ULL << sourceSquare))
+    {
+      pieceAttacks &= LineThrough[masks.kingSquare][sourceSquare];
+    }
 
     while (pieceAttacks)
     {
       int targetSquare = __builtin_ctzll(pieceAttacks);
-      bool isCapture = ((1ULL << targetSquare) & (isWhite ? board.blackPieces : board.whitePieces));
-      moves.push_back({sourceSquare, targetSquare, ' ', isCapture});
+      bool isCapture = board.pieceAt(targetSquare) != NO_PIECE; // Friendly squares are already masked out
+      moves.push_back(PackedMove(sourceSquare, targetSquare, isCapture ? CAPTURE : QUIET_MOVE));
       pieceAttacks &= pieceAttacks - 1;
     }
     queens &= queens - 1;
   }
 }
 
-void generateKingMoves(Bitboards board, bool isWhite, std::vector<Move> &moves)
+void generateKingMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves)
 {
   uint64_t king = isWhite ? board.whiteKings : board.blackKings;
   uint64_t friendlies = isWhite ? board.whitePieces : board.blackPieces;
 
+  if (!king)
+  {
+    return;
+  }
+
   int sourceSquare = __builtin_ctzll(king);
-  uint64_t attacks = board.generateKingAttacks(king, isWhite) & ~friendlies;
+  uint64_t targets = modeTargets(board, isWhite, masks, attacks<KING>(sourceSquare) & ~friendlies);
 
-  while (attacks)
+  // The king is taken off the board for the test, so it cannot hide behind
+  // itself from a slider checking along the line it retreats on
+  uint64_t occupied = (board.whitePieces | board.blackPieces) ^ king;
+
+  while (targets)
   {
-    int targetSquare = __builtin_ctzll(attacks);
-    bool isCapture = ((1ULL << targetSquare) & (isWhite ? board.blackPieces : board.whitePieces));
-    moves.push_back({sourceSquare, targetSquare, ' ', isCapture});
-    attacks &= attacks - 1;
+    int targetSquare = __builtin_ctzll(targets);
+    targets &= targets - 1;
+    if (!isSafe(board, isWhite, targetSquare, occupied, 1ULL << targetSquare))
+    {
+      continue;
+    }
+    bool isCapture = board.pieceAt(targetSquare) != NO_PIECE; // Friendly squares are already masked out
+    moves.push_back(PackedMove(sourceSquare, targetSquare, isCapture ? CAPTURE : QUIET_MOVE));
   }
-  // Add castling moves
+
+  // Add castling moves: never out of check, the squares between king and rook
+  // must be empty and the king may not pass or land on an attacked square
+  if (masks.checkers || masks.capturesOnly)
+  {
+    return;
+  }
+  occupied |= king;
   if (isWhite)
   {
     // Kingside Castling
-    if (board.whiteKingCastle &&
-        !(board.whitePieces & 0x6000000000000000ULL) &&
-        !(board.blackPieceAttacks & 0x7000000000000000ULL))
+    if (board.whiteKingCastle && !(occupied & 0x6000000000000000ULL) &&
+        isSafe(board, isWhite, 61, occupied) && isSafe(board, isWhite, 62, occupied))
     {
-      moves.push_back({sourceSquare, 62, 'O', false});
+      moves.push_back(PackedMove(sourceSquare, 62, KING_CASTLE));
     }
 
     // Queenside Castling
-    if (board.whiteQueenCastle &&
-        !(board.whitePieces & 0x0C00000000000000ULL) &&
-        !(board.blackPieceAttacks & 0x1C00000000000000ULL))
+    if (board.whiteQueenCastle && !(occupied & 0x0E00000000000000ULL) &&
+        isSafe(board, isWhite, 59, occupied) && isSafe(board, isWhite, 58, occupied))
     {
-      moves.push_back({sourceSquare, 58, 'O', false});
+      moves.push_back(PackedMove(sourceSquare, 58, QUEEN_CASTLE));
     }
   }
   else
   {
     // Kingside Castling
-    if (board.blackKingCastle &&
-        !(board.blackPieces & 0x0000000000000060ULL) &&
-        !(board.whitePieceAttacks & 0x0000000000000070ULL))
+    if (board.blackKingCastle && !(occupied & 0x0000000000000060ULL) &&
+        isSafe(board, isWhite, 5, occupied) && isSafe(board, isWhite, 6, occupied))
     {
-      moves.push_back({sourceSquare, 6, 'O', false});
+      moves.push_back(PackedMove(sourceSquare, 6, KING_CASTLE));
     }
 
     // Queenside Castling
-    if (board.blackQueenCastle &&
-        !(board.blackPieces & 0x000000000000000CULL) &&
-        !(board.whitePieceAttacks & 0x000000000000001CULL))
+    if (board.blackQueenCastle && !(occupied & 0x000000000000000EULL) &&
+        isSafe(board, isWhite, 3, occupied) && isSafe(board, isWhite, 2, occupied))
     {
-      moves.push_back({sourceSquare, 2, 'O', false});
+      moves.push_back(PackedMove(sourceSquare, 2, QUEEN_CASTLE));
     }
   }
 }
 
-std::vector<Move> generateLegalMoves(const Bitboards &board, bool isWhite)
+// Shared body of generateLegalMoves, generateCaptures and generateQuiets
+static MoveList generateMoves(const Bitboards &board, bool isWhite, bool capturesOnly, bool quietsOnly)
 {
-  std::vector<Move> moves;
+  MoveList moves;
+  MoveMasks masks = computeMoveMasks(board, isWhite, capturesOnly, quietsOnly);
 
-  generatePawnMoves(board, isWhite, moves);
-  generateKnightMoves(board, isWhite, moves);
-  generateBishopMoves(board, isWhite, moves);
-  generateRookMoves(board, isWhite, moves);
-  generateQueenMoves(board, isWhite, moves);
-  generateKingMoves(board, isWhite, moves);
+  // In double check only the king can move
+  if (!(masks.checkers & (masks.checkers - 1)))
+  {
+    generatePawnMoves(board, isWhite, masks, moves);
+    generateKnightMoves(board, isWhite, masks, moves);
+    generateBishopMoves(board, isWhite, masks, moves);
+    generateRookMoves(board, isWhite, masks, moves);
+    generateQueenMoves(board, isWhite, masks, moves);
+  }
+  generateKingMoves(board, isWhite, masks, moves);
 
   return moves;
 }
 
+MoveList generateLegalMoves(const Bitboards &board, bool isWhite)
+{
+  return generateMoves(board, isWhite, false, false);
+}
+
+MoveList generateCaptures(const Bitboards &board, bool isWhite)
+{
+  return generateMoves(board, isWhite, true, false);
+}
+
+MoveList generateQuiets(const Bitboards &board, bool isWhite)
+{
+  return generateMoves(board, isWhite, false, true);
+}
+
+bool isLegalMove(const Bitboards &board, PackedMove move)
+{
+  Piece piece = board.pieceAt(move.sourceSquare());
+  if (move.isNull() || piece == NO_PIECE || (colorOf(piece) == WHITE) != board.whiteToMove)
+  {
+    return false;
+  }
+
+  bool isWhite = board.whiteToMove;
+  MoveMasks masks = computeMoveMasks(board, isWhite);
+  if ((masks.checkers & (masks.checkers - 1)) && typeOf(piece) != KING)
+  {
+    return false;
+  }
+
+  MoveList moves;
+  switch (typeOf(piece))
+  {
+  case PAWN:
+    generatePawnMoves(board, isWhite, masks, moves);
+    break;
+  case KNIGHT:
+    generateKnightMoves(board, isWhite, masks, moves);
+    break;
+  case BISHOP:
+    generateBishopMoves(board, isWhite, masks, moves);
+    break;
+  case ROOK:
+    generateRookMoves(board, isWhite, masks, moves);
+    break;
+  case QUEEN:
+    generateQueenMoves(board, isWhite, masks, moves);
+    break;
+  default:
+    generateKingMoves(board, isWhite, masks, moves);
+    break;
+  }
+
+  for (PackedMove candidate : moves)
+  {
+    if (candidate == move)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 std::string squareToString(int square)
 {
   char file = 'a' + (square % 8); // File (a-h)
@@ -249,10 +484,11 @@ std::string squareToString(int square)
   return std::string(1, file) + std::string(1, rank);
 }
 
-void printMoves(const std::vector<Move> &moves)
+void printMoves(const MoveList &moves)
 {
-  for (const auto &move : moves)
+  for (PackedMove packed : moves)
   {
+    Move move = toMove(packed);
     std::string moveStr = squareToString(move.sourceSquare) +
                           "-" +
                           squareToString(move.targetSquare);
@@ -270,3 +506,78 @@ void printMoves(const std::vector<Move> &moves)
     std::cout << moveStr << "\n";
   }
 }
+
+Move toMove(PackedMove move)
+{
+  static const char promotionLetters[4] = {'N', 'B', 'R', 'Q'};
+
+  char moveType = ' ';
+  if (move.isPromotion())
+  {
+    moveType = promotionLetters[move.flags() & 3];
+  }
+  else if (move.isCastle())
+  {
+    moveType = 'O';
+  }
+  else if (move.flags() == DOUBLE_PUSH)
+  {
+    moveType = 'D';
+  }
+
+  return Move{move.sourceSquare(), move.targetSquare(), moveType, move.isCapture()};
+}
+
+std::string moveToString(PackedMove move)
+{
+  Move readable = toMove(move);
+  std::string text = squareToString(readable.sourceSquare) + squareToString(readable.targetSquare);
+  if (move.isPromotion())
+  {
+    text += readable.moveType;
+  }
+  return text;
+}
+
+std::string moveToUci(PackedMove move)
+{
+  if (move.isNull())
+  {
+    return "0000";
+  }
+  std::string text = moveToString(move);
+  if (text.size() == 5)
+  {
+    text[4] = char(std::tolower(static_cast<unsigned char>(text[4])));
+  }
+  return text;
+}
+
+PackedMove packMove(const Bitboards &board, const Move &move)
+{
+  for (PackedMove candidate : generateLegalMoves(board, board.whiteToMove))
+  {
+    Move readable = toMove(candidate);
+    if (readable.sourceSquare == move.sourceSquare && readable.targetSquare == move.targetSquare &&
+        (!candidate.isPromotion() || readable.moveType == move.moveType))
+    {
+      return candidate;
+    }
+  }
+  return PackedMove();
+}
+
+PackedMove parseMove(const Bitboards &board, const std::string &text)
+{
+  for (PackedMove candidate : generateLegalMoves(board, board.whiteToMove))
+  {
+    std::string candidateText = moveToString(candidate);
+    if (candidateText.size() == text.size() &&
+        candidateText.compare(0, 4, text, 0, 4) == 0 &&
+        (text.size() == 4 || candidateText[4] == std::toupper(static_cast<unsigned char>(text[4]))))
+    {
+      return candidate;
+    }
+  }
+  return PackedMove();
+}
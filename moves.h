@@ -1,9 +1,10 @@
 #ifndef MOVES_H
 #define MOVES_H
 
-#include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include "types.h"
 
 class Bitboards;
 
@@ -21,15 +22,136 @@ inline bool operator==(const Move &a, const Move &b)
   return a.sourceSquare == b.sourceSquare && a.targetSquare == b.targetSquare && a.moveType == b.moveType && a.isCapture == b.isCapture;
 }
 
-// Move generation functions
-std::vector<Move> generateLegalMoves(const Bitboards &board, bool isWhite);
-void generatePawnMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void generateKnightMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void generateBishopMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void generateRookMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void generateQueenMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void generateKingMoves(Bitboards board, bool isWhite, std::vector<Move> &moves);
-void printMoves(const std::vector<Move> &moves);
+// Flag nibble of a PackedMove. Bit 2 marks captures and bit 3 promotions;
+// the low two bits of a promotion give the piece (knight, bishop, rook, queen).
+enum MoveFlag
+{
+  QUIET_MOVE = 0,
+  DOUBLE_PUSH = 1,
+  KING_CASTLE = 2,
+  QUEEN_CASTLE = 3,
+  CAPTURE = 4,
+  EN_PASSANT = 5,
+  PROMOTION = 8,
+  KNIGHT_PROMOTION = 8,
+  BISHOP_PROMOTION = 9,
+  ROOK_PROMOTION = 10,
+  QUEEN_PROMOTION = 11,
+};
+
+// 16-bit move used inside move generation and search:
+// bits 0-5 source square, bits 6-11 target square, bits 12-15 MoveFlag.
+// The all-zero value (a8 to a8) is never a real move and serves as "no move".
+class PackedMove
+{
+public:
+  PackedMove() : data(0) {}
+  PackedMove(int sourceSquare, int targetSquare, int flags)
+      : data(uint16_t(sourceSquare | (targetSquare << 6) | (flags << 12))) {}
+
+  int sourceSquare() const { return data & 63; }
+  int targetSquare() const { return (data >> 6) & 63; }
+  int flags() const { return data >> 12; }
+
+  bool isCapture() const { return flags() & CAPTURE; }
+  bool isPromotion() const { return flags() & PROMOTION; }
+  bool isEnPassant() const { return flags() == EN_PASSANT; }
+  bool isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+  PieceType promotionType() const { return PieceType(KNIGHT + (flags() & 3)); }
+
+  bool isNull() const { return data == 0; }
+  uint16_t raw() const { return data; }
+  static PackedMove fromRaw(uint16_t raw)
+  {
+    PackedMove move;
+    move.data = raw;
+    return move;
+  }
+
+  bool operator==(PackedMove other) const { return data == other.data; }
+  bool operator!=(PackedMove other) const { return data != other.data; }
+
+private:
+  uint16_t data;
+};
+
+// Fixed-capacity move list that lives on the caller's stack. 256 is above
+// the most moves any chess position can have.
+class MoveList
+{
+public:
+  static const size_t Capacity = 256;
+
+  MoveList() : count(0) {}
+
+  void push_back(PackedMove move) { moves[count++] = move; }
+  void clear() { count = 0; }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  PackedMove &operator[](size_t i) { return moves[i]; }
+  PackedMove operator[](size_t i) const { return moves[i]; }
+
+  PackedMove *begin() { return moves; }
+  PackedMove *end() { return moves + count; }
+  const PackedMove *begin() const { return moves; }
+  const PackedMove *end() const { return moves + count; }
+
+private:
+  PackedMove moves[Capacity];
+  size_t count;
+};
+
+// What makes a move legal for one side in one position, computed once per
+// node and shared by the piece generators
+struct MoveMasks
+{
+  uint64_t checkers; // Enemy pieces giving check
+  uint64_t pinned;   // Own pieces that may only move along the line to their king
+  uint64_t targets;  // Squares other pieces than the king may move to: not friendly,
+                     // and blocking or capturing the checker when in single check
+  int kingSquare;    // -1 if the side has no king
+  bool capturesOnly; // Generate only captures and promotions
+  bool quietsOnly;   // Generate only the other moves (castling included)
+};
+
+MoveMasks computeMoveMasks(const Bitboards &board, bool isWhite, bool capturesOnly = false, bool quietsOnly = false);
+
+// Move generation functions. generateLegalMoves returns only moves that do
+// not leave the mover's king in check.
+MoveList generateLegalMoves(const Bitboards &board, bool isWhite);
+
+// The legal captures (en passant included) and promotions only, for
+// quiescence search
+MoveList generateCaptures(const Bitboards &board, bool isWhite);
+
+// The legal moves generateCaptures leaves out, for the quiet move stage of
+// the move picker
+MoveList generateQuiets(const Bitboards &board, bool isWhite);
+
+// True if 'move' is one of the legal moves of the side to move. Only the
+// moving piece's type is generated, so this is cheap enough to validate
+// hash and killer moves.
+bool isLegalMove(const Bitboards &board, PackedMove move);
+void generatePawnMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void generateKnightMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void generateBishopMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void generateRookMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void generateQueenMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void generateKingMoves(const Bitboards &board, bool isWhite, const MoveMasks &masks, MoveList &moves);
+void printMoves(const MoveList &moves);
 std::string squareToString(int square);
 
+// Conversions between the packed and the readable forms
+Move toMove(PackedMove move);
+std::string moveToString(PackedMove move); // "e2e4", promotions as "e7e8Q"
+std::string moveToUci(PackedMove move);    // "e2e4", promotions as "e7e8q", no move as "0000"
+
+// Finds the generated move matching 'move' / text such as "e7e8Q" (the
+// promotion letter may be either case). Returns a null PackedMove if the
+// side to move has no such move.
+PackedMove packMove(const Bitboards &board, const Move &move);
+PackedMove parseMove(const Bitboards &board, const std::string &text);
+
 #endif // MOVES_H
@@ -0,0 +1,487 @@
+#include "nnue.h"
+#include "bitboards.h"
+#include "filemap.h"
+#include "psqt.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef HAS_AVX2_BACKEND
+#include <immintrin.h>
+#endif
+
+using namespace Nnue;
+
+NnueBackend ActiveNnueBackend = NNUE_SCALAR;
+
+namespace
+{
+  // File layout: this header, then each section below in order. Every
+  // section is a multiple of 32 bytes, so all of them stay 32-byte aligned
+  // in the (page-aligned) mapping.
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t featureCount;
+    uint32_t halfDims;
+    uint32_t l1Size;
+    uint32_t l2Size;
+    char reserved[36];
+  };
+  static_assert(sizeof(FileHeader) == 64, "network header must keep the sections aligned");
+
+  const char FileMagic[8] = {'C', 'E', 'N', 'N', 'U', 'E', '0', '1'};
+  const uint32_t FileVersion = 1;
+
+  struct Network
+  {
+    const int16_t *featureBiases;  // [HalfDims]
+    const int16_t *featureWeights; // [FeatureCount][HalfDims]
+    const int32_t *l1Biases;       // [L1Size]
+    const int8_t *l1Weights;       // [L1Size][2 * HalfDims]
+    const int32_t *l2Biases;       // [L2Size]
+    const int8_t *l2Weights;       // [L2Size][L1Size]
+    const int8_t *outputWeights;   // [L2Size]
+    const int32_t *outputBias;     // [1], padded to 32 bytes
+  };
+
+  const size_t FileSize = sizeof(FileHeader) +
+                          HalfDims * sizeof(int16_t) +
+                          size_t(FeatureCount) * HalfDims * sizeof(int16_t) +
+                          L1Size * sizeof(int32_t) +
+                          L1Size * 2 * HalfDims +
+                          L2Size * sizeof(int32_t) +
+                          L2Size * L1Size +
+                          L2Size +
+                          32;
+
+  // Points the sections of a network at consecutive parts of 'data'
+  Network layoutNetwork(const char *data)
+  {
+    Network net;
+    const char *p = data + sizeof(FileHeader);
+    net.featureBiases = reinterpret_cast<const int16_t *>(p);
+    p += HalfDims * sizeof(int16_t);
+    net.featureWeights = reinterpret_cast<const int16_t *>(p);
+    p += size_t(FeatureCount) * HalfDims * sizeof(int16_t);
+    net.l1Biases = reinterpret_cast<const int32_t *>(p);
+    p += L1Size * sizeof(int32_t);
+    net.l1Weights = reinterpret_cast<const int8_t *>(p);
+    p += L1Size * 2 * HalfDims;
+    net.l2Biases = reinterpret_cast<const int32_t *>(p);
+    p += L2Size * sizeof(int32_t);
+    net.l2Weights = reinterpret_cast<const int8_t *>(p);
+    p += L2Size * L1Size;
+    net.outputWeights = reinterpret_cast<const int8_t *>(p);
+    p += L2Size;
+    net.outputBias = reinterpret_cast<const int32_t *>(p);
+    return net;
+  }
+
+  FileMapping mapping;
+  Network network;
+
+  int kingSquare(const Bitboards &board, Color color)
+  {
+    uint64_t king = color == WHITE ? board.whiteKings : board.blackKings;
+    return king ? __builtin_ctzll(king) : 0; // Kingless test positions use a1 mirrored
+  }
+
+  // Input index of 'piece' on 'square' as seen by 'perspective'
+  int featureIndex(Color perspective, int king, Piece piece, int square)
+  {
+    int flip = perspective == WHITE ? 0 : 56;
+    int kind = (typeOf(piece) - PAWN) * 2 + (colorOf(piece) != perspective);
+    return ((king ^ flip) * PieceKinds + kind) * 64 + (square ^ flip);
+  }
+
+  const int16_t *featureRow(Color perspective, int king, Piece piece, int square)
+  {
+    return network.featureWeights + size_t(featureIndex(perspective, king, piece, square)) * HalfDims;
+  }
+
+  // out = in + the 'added' rows - the 'removed' rows, in int16 wrapping arithmetic
+  void applyRowsScalar(const int16_t *in, int16_t *out, const int16_t *const *added, int addCount,
+                       const int16_t *const *removed, int removeCount)
+  {
+    for (int i = 0; i < HalfDims; i++)
+    {
+      uint16_t v = uint16_t(in[i]);
+      for (int r = 0; r < addCount; r++)
+        v += uint16_t(added[r][i]);
+      for (int r = 0; r < removeCount; r++)
+        v -= uint16_t(removed[r][i]);
+      out[i] = int16_t(v);
+    }
+  }
+
+  // Clips each accumulator value to [0, 127], side to move first
+  void transformScalar(const Accumulator &acc, Color stm, uint8_t *out)
+  {
+    const int16_t *halves[2] = {acc.values[stm], acc.values[!stm]};
+    for (int h = 0; h < 2; h++)
+    {
+      for (int i = 0; i < HalfDims; i++)
+      {
+        out[h * HalfDims + i] = uint8_t(std::clamp<int>(halves[h][i], 0, 127));
+      }
+    }
+  }
+
+  // out[o] = biases[o] + sum of in[i] * weights[o][i]
+  void denseScalar(const uint8_t *in, int inSize, const int8_t *weights, const int32_t *biases,
+                   int outSize, int32_t *out)
+  {
+    for (int o = 0; o < outSize; o++)
+    {
+      int32_t sum = biases[o];
+      const int8_t *row = weights + o * inSize;
+      for (int i = 0; i < inSize; i++)
+      {
+        sum += int32_t(in[i]) * row[i];
+      }
+      out[o] = sum;
+    }
+  }
+
+#ifdef HAS_AVX2_BACKEND
+  // The same kernels on 256-bit vectors. They are compiled for AVX2 alone,
+  // so the rest of the program needs no -mavx2 and still runs on older CPUs;
+  // they are only called after cpuHasAvx2() said yes.
+  __attribute__((target("avx2"))) void applyRowsAvx2(const int16_t *in, int16_t *out,
+                                                     const int16_t *const *added, int addCount,
+                                                     const int16_t *const *removed, int removeCount)
+  {
+    for (int i = 0; i < HalfDims; i += 16)
+    {
+      __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(in + i));
+      for (int r = 0; r < addCount; r++)
+        v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(added[r] + i)));
+      for (int r = 0; r < removeCount; r++)
+        v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(removed[r] + i)));
+      _mm256_store_si256(reinterpret_cast<__m256i *>(out + i), v);
+    }
+  }
+
+  __attribute__((target("avx2"))) void transformAvx2(const Accumulator &acc, Color stm, uint8_t *out)
+  {
+    const int16_t *halves[2] = {acc.values[stm], acc.values[!stm]};
+    const __m256i zero = _mm256_setzero_si256();
+    for (int h = 0; h < 2; h++)
+    {
+      for (int i = 0; i < HalfDims; i += 32)
+      {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(halves[h] + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(halves[h] + i + 16));
+        // packs saturates to [-128, 127] but interleaves the 128-bit lanes;
+        // the permute puts them back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(out + h * HalfDims + i), _mm256_max_epi8(packed, zero));
+      }
+    }
+  }
+
+  __attribute__((target("avx2"))) void denseAvx2(const uint8_t *in, int inSize, const int8_t *weights,
+                                                 const int32_t *biases, int outSize, int32_t *out)
+  {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < outSize; o++)
+    {
+      const int8_t *row = weights + o * inSize;
+      __m256i sum = _mm256_setzero_si256();
+      for (int i = 0; i < inSize; i += 32)
+      {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        // u8 * i8 pairs summed to i16 (inputs are at most 127, so this
+        // cannot saturate), then pairs of those summed to i32
+        __m256i products = _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones);
+        sum = _mm256_add_epi32(sum, products);
+      }
+      __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+      out[o] = biases[o] + _mm_cvtsi128_si32(s);
+    }
+  }
+#endif
+
+  void applyRows(const int16_t *in, int16_t *out, const int16_t *const *added, int addCount,
+                 const int16_t *const *removed, int removeCount)
+  {
+#ifdef HAS_AVX2_BACKEND
+    if (ActiveNnueBackend == NNUE_AVX2)
+    {
+      applyRowsAvx2(in, out, added, addCount, removed, removeCount);
+      return;
+    }
+#endif
+    applyRowsScalar(in, out, added, addCount, removed, removeCount);
+  }
+
+  void transform(const Accumulator &acc, Color stm, uint8_t *out)
+  {
+#ifdef HAS_AVX2_BACKEND
+    if (ActiveNnueBackend == NNUE_AVX2)
+    {
+      transformAvx2(acc, stm, out);
+      return;
+    }
+#endif
+    transformScalar(acc, stm, out);
+  }
+
+  void dense(const uint8_t *in, int inSize, const int8_t *weights, const int32_t *biases, int outSize, int32_t *out)
+  {
+#ifdef HAS_AVX2_BACKEND
+    if (ActiveNnueBackend == NNUE_AVX2)
+    {
+      denseAvx2(in, inSize, weights, biases, outSize, out);
+      return;
+    }
+#endif
+    denseScalar(in, inSize, weights, biases, outSize, out);
+  }
+
+  // Clipped ReLU between the dense layers
+  void activate(const int32_t *in, int size, uint8_t *out)
+  {
+    for (int i = 0; i < size; i++)
+    {
+      out[i] = uint8_t(std::clamp(in[i] >> WeightScaleBits, 0, 127));
+    }
+  }
+
+  void refreshPerspective(const Bitboards &board, Color perspective, int16_t *values)
+  {
+    const int16_t *rows[64]; // One per non-king piece; legal or not, a board has at most 64
+    int count = 0;
+    int king = kingSquare(board, perspective);
+    uint64_t pieces = (board.whitePieces | board.blackPieces) & ~(board.whiteKings | board.blackKings);
+    for (; pieces; pieces &= pieces - 1)
+    {
+      int square = __builtin_ctzll(pieces);
+      rows[count++] = featureRow(perspective, king, board.pieceAt(square), square);
+    }
+
+    // Added a few rows per pass, so each value is loaded and stored less often
+    std::memcpy(values, network.featureBiases, HalfDims * sizeof(int16_t));
+    for (int i = 0; i < count; i += 4)
+    {
+      applyRows(values, values, rows + i, std::min(4, count - i), nullptr, 0);
+    }
+  }
+}
+
+bool loadNetwork(const std::string &path)
+{
+  FileMapping m;
+  if (!mapFile(path, m))
+  {
+    std::cerr << "Cannot map network file " << path << std::endl;
+    return false;
+  }
+
+  FileHeader header;
+  bool valid = m.size == FileSize;
+  if (valid)
+  {
+    std::memcpy(&header, m.data, sizeof(header));
+    valid = std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) == 0 && header.version == FileVersion &&
+            header.featureCount == uint32_t(FeatureCount) && header.halfDims == uint32_t(HalfDims) &&
+            header.l1Size == uint32_t(L1Size) && header.l2Size == uint32_t(L2Size);
+  }
+  if (!valid)
+  {
+    std::cerr << "Network file " << path << " does not match this engine's architecture" << std::endl;
+    unmapFile(m);
+    return false;
+  }
+
+  unmapFile(mapping);
+  mapping = m;
+  network = layoutNetwork(mapping.data);
+  setNnueBackend(NNUE_AVX2);
+  return true;
+}
+
+bool networkLoaded()
+{
+  return mapping.data != nullptr;
+}
+
+bool cpuHasAvx2()
+{
+#ifdef HAS_AVX2_BACKEND
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+void setNnueBackend(NnueBackend backend)
+{
+  ActiveNnueBackend = backend == NNUE_AVX2 && cpuHasAvx2() ? NNUE_AVX2 : NNUE_SCALAR;
+}
+
+const char *nnueBackendName(NnueBackend backend)
+{
+  return backend == NNUE_AVX2 ? "avx2" : "scalar";
+}
+
+void refreshAccumulator(const Bitboards &board, Accumulator &accumulator)
+{
+  refreshPerspective(board, WHITE, accumulator.values[WHITE]);
+  refreshPerspective(board, BLACK, accumulator.values[BLACK]);
+}
+
+void updateAccumulator(const Accumulator &before, Accumulator &after, const Bitboards &board,
+                       PackedMove move, Piece captured)
+{
+  int source = move.sourceSquare();
+  int target = move.targetSquare();
+  Piece moved = board.pieceAt(target);
+  Color us = colorOf(moved);
+
+  // Pieces that left a square and pieces that arrived on one
+  Piece removedPieces[3], addedPieces[2];
+  int removedSquares[3], addedSquares[2];
+  int removeCount = 0, addCount = 0;
+
+  removedPieces[removeCount] = move.isPromotion() ? makePiece(us, PAWN) : moved;
+  removedSquares[removeCount++] = source;
+  addedPieces[addCount] = moved;
+  addedSquares[addCount++] = target;
+
+  if (captured != NO_PIECE)
+  {
+    removedPieces[removeCount] = captured;
+    removedSquares[removeCount++] = move.isEnPassant() ? (us == WHITE ? target + 8 : target - 8) : target;
+  }
+  if (move.isCastle())
+  {
+    int rookSource, rookTarget;
+    castlingRookSquares(move, rookSource, rookTarget);
+    Piece rook = makePiece(us, ROOK);
+    removedPieces[removeCount] = rook;
+    removedSquares[removeCount++] = rookSource;
+    addedPieces[addCount] = rook;
+    addedSquares[addCount++] = rookTarget;
+  }
+
+  for (Color perspective : {WHITE, BLACK})
+  {
+    if (typeOf(moved) == KING && perspective == us)
+    {
+      refreshPerspective(board, perspective, after.values[perspective]);
+      continue;
+    }
+
+    // Kings are not inputs themselves
+    int king = kingSquare(board, perspective);
+    const int16_t *added[2], *removed[3];
+    int a = 0, r = 0;
+    for (int i = 0; i < addCount; i++)
+    {
+      if (typeOf(addedPieces[i]) != KING)
+        added[a++] = featureRow(perspective, king, addedPieces[i], addedSquares[i]);
+    }
+    for (int i = 0; i < removeCount; i++)
+    {
+      if (typeOf(removedPieces[i]) != KING)
+        removed[r++] = featureRow(perspective, king, removedPieces[i], removedSquares[i]);
+    }
+    applyRows(before.values[perspective], after.values[perspective], added, a, removed, r);
+  }
+}
+
+int evaluateNnue(const Bitboards &board, const Accumulator &accumulator)
+{
+  Color stm = board.whiteToMove ? WHITE : BLACK;
+  alignas(32) uint8_t input[2 * HalfDims];
+  alignas(32) int32_t l1[L1Size];
+  alignas(32) uint8_t l1Out[L1Size];
+  alignas(32) int32_t l2[L2Size];
+  alignas(32) uint8_t l2Out[L2Size];
+  int32_t output;
+
+  transform(accumulator, stm, input);
+  dense(input, 2 * HalfDims, network.l1Weights, network.l1Biases, L1Size, l1);
+  activate(l1, L1Size, l1Out);
+  dense(l1Out, L1Size, network.l2Weights, network.l2Biases, L2Size, l2);
+  activate(l2, L2Size, l2Out);
+  dense(l2Out, L2Size, network.outputWeights, network.outputBias, 1, &output);
+
+  int score = output / OutputScale;
+  return stm == WHITE ? score : -score;
+}
+
+bool writePsqNetwork(const std::string &path)
+{
+  // Built in memory with the same layout the loader maps
+  std::vector<char> file(FileSize, 0);
+  FileHeader header = {};
+  std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+  header.version = FileVersion;
+  header.featureCount = FeatureCount;
+  header.halfDims = HalfDims;
+  header.l1Size = L1Size;
+  header.l2Size = L2Size;
+  std::memcpy(file.data(), &header, sizeof(header));
+
+  Network net = layoutNetwork(file.data());
+  int16_t *featureWeights = const_cast<int16_t *>(net.featureWeights);
+  int32_t *l1Biases = const_cast<int32_t *>(net.l1Biases);
+  int8_t *l1Weights = const_cast<int8_t *>(net.l1Weights);
+  int8_t *l2Weights = const_cast<int8_t *>(net.l2Weights);
+  int8_t *outputWeights = const_cast<int8_t *>(net.outputWeights);
+
+  // Accumulator units 0-2 hold the side's own pawns, minor pieces and major
+  // pieces, each in centipawns divided by its unit's scale, small enough
+  // that a full set stays below the clip at 127
+  const int Unit[7] = {0, 0, 1, 1, 2, 2, 0};     // By PieceType
+  const int UnitScale[3] = {10, 12, 20};
+  for (int king = 0; king < 64; king++)
+  {
+    for (int type = PAWN; type <= QUEEN; type++)
+    {
+      for (int square = 0; square < 64; square++)
+      {
+        // Squares are already seen from the side's own end, as the tables are for white
+        int value = mgValue(PSQT.values[makePiece(WHITE, PieceType(type))][square]);
+        int index = featureIndex(WHITE, king, makePiece(WHITE, PieceType(type)), square);
+        int unit = Unit[type];
+        featureWeights[size_t(index) * HalfDims + unit] = int16_t((value + UnitScale[unit] / 2) / UnitScale[unit]);
+      }
+    }
+  }
+
+  // L1 units 0-7 give the material difference from the side to move's view
+  // and units 8-15 its negation, both in 64 cp steps. The biases offset each
+  // of the eight copies by 8 cp more, so together they count 8 cp steps.
+  for (int o = 0; o < 16; o++)
+  {
+    int sign = o < 8 ? 1 : -1;
+    l1Biases[o] = (o % 8) * 8;
+    for (int unit = 0; unit < 3; unit++)
+    {
+      l1Weights[o * 2 * HalfDims + unit] = int8_t(sign * UnitScale[unit]);
+      l1Weights[o * 2 * HalfDims + HalfDims + unit] = int8_t(-sign * UnitScale[unit]);
+    }
+  }
+
+  // L2 passes those sixteen units through unchanged
+  for (int o = 0; o < 16; o++)
+  {
+    l2Weights[o * L1Size + o] = 1 << WeightScaleBits;
+    // Each copy counts 8 cp: 8 * OutputScale output units
+    outputWeights[o] = int8_t((o < 8 ? 1 : -1) * 8 * OutputScale);
+  }
+
+  std::ofstream out(path, std::ios::binary);
+  out.write(file.data(), std::streamsize(file.size()));
+  return bool(out);
+}
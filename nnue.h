@@ -0,0 +1,81 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "moves.h"
+#include "types.h"
+
+class Bitboards;
+
+// AVX2 kernels are only built for x86-64. Define NO_AVX2 to build without them.
+#if defined(__x86_64__) && !defined(NO_AVX2)
+#define HAS_AVX2_BACKEND
+#endif
+
+// Which kernels evaluate the network
+enum NnueBackend
+{
+  NNUE_SCALAR, // Plain C++, runs anywhere
+  NNUE_AVX2,   // 256-bit integer SIMD
+};
+
+extern NnueBackend ActiveNnueBackend;
+
+// Efficiently updatable network with HalfKP-like inputs. Each side has its
+// own view of the board: one input per (own king square, non-king piece,
+// square), all mirrored vertically for black. The inputs feed a HalfDims
+// wide int16 accumulator per side, which is kept up to date by adding and
+// subtracting weight rows as pieces move. The two accumulators, side to
+// move first, are clipped to [0, 127] and pass through two small int8
+// layers with clipped ReLU to one output.
+namespace Nnue
+{
+  const int PieceKinds = 10; // Pawn to queen, own then enemy
+  const int FeatureCount = 64 * PieceKinds * 64;
+  const int HalfDims = 128;
+  const int L1Size = 32;
+  const int L2Size = 32;
+
+  const int WeightScaleBits = 6; // Dense layer outputs are shifted down by this
+  const int OutputScale = 8;     // Network output units per centipawn
+}
+
+// One side's accumulator per Color, summed over its active features
+struct alignas(32) Accumulator
+{
+  int16_t values[2][Nnue::HalfDims];
+};
+
+// Maps a network file into memory, checks its header and size, and picks
+// the AVX2 kernels if this CPU supports them. Returns false (with the
+// previous network, if any, still loaded) when the file is unusable.
+bool loadNetwork(const std::string &path);
+
+bool networkLoaded();
+
+// Forces the scalar kernels, or selects the fastest the CPU supports
+void setNnueBackend(NnueBackend backend);
+bool cpuHasAvx2();
+
+// "scalar" or "avx2"
+const char *nnueBackendName(NnueBackend backend);
+
+// Computes both sides' accumulators from scratch
+void refreshAccumulator(const Bitboards &board, Accumulator &accumulator);
+
+// Derives the accumulator after 'move' from the one before it. 'board' is
+// the position after the move and 'captured' the piece it took. A king
+// move rebuilds its own side's accumulator, as every feature depends on it.
+void updateAccumulator(const Accumulator &before, Accumulator &after, const Bitboards &board,
+                       PackedMove move, Piece captured);
+
+// Network output in centipawns from white's point of view
+int evaluateNnue(const Bitboards &board, const Accumulator &accumulator);
+
+// Writes a network that reproduces material plus middlegame piece-square
+// values, so the evaluator can run without a trained file
+bool writePsqNetwork(const std::string &path);
+
+#endif // NNUE_H
@@ -0,0 +1,129 @@
+#include "pawns.h"
+#include "bitboards.h"
+
+namespace
+{
+  using namespace PawnTerms;
+
+  const uint64_t FileA = 0x0101010101010101ULL;
+  const uint64_t FileH = 0x8080808080808080ULL;
+
+  // Pawn shield bonus per pawn one and two rows in front of the king
+  const int ShieldNear = 12;
+  const int ShieldFar = 6;
+
+  uint64_t adjacentFiles(int file)
+  {
+    return (file > 0 ? FileA << (file - 1) : 0) | (file < 7 ? FileA << (file + 1) : 0);
+  }
+
+  uint64_t fillUp(uint64_t b)
+  {
+    b |= b >> 8;
+    b |= b >> 16;
+    return b | b >> 32;
+  }
+
+  uint64_t fillDown(uint64_t b)
+  {
+    b |= b << 8;
+    b |= b << 16;
+    return b | b << 32;
+  }
+
+  // Squares beside each set square, on the same row
+  uint64_t sideways(uint64_t b)
+  {
+    return ((b << 1) & ~FileA) | ((b >> 1) & ~FileH);
+  }
+
+  // "Up" is towards row 0, white's direction
+  Score evaluateSide(Color us, uint64_t ours, uint64_t theirs)
+  {
+    uint64_t files = fillUp(fillDown(ours));
+    uint64_t isolated = ours & ~sideways(files);
+    int doubled = __builtin_popcountll(ours) - __builtin_popcountll(files & 0xFF);
+
+    // Enemy pawns on this or a neighbouring file block every square behind them
+    uint64_t stoppers = theirs | sideways(theirs);
+    uint64_t passed = ours & ~(us == WHITE ? fillDown(stoppers << 8) : fillUp(stoppers >> 8));
+
+    // Backward: has neighbours, none level with or behind it, and an enemy
+    // pawn guards the square in front
+    uint64_t supported = sideways(us == WHITE ? fillUp(ours) : fillDown(ours));
+    uint64_t guarded = us == WHITE ? (((theirs << 7) & ~FileH) | ((theirs << 9) & ~FileA)) << 8
+                                   : (((theirs >> 9) & ~FileH) | ((theirs >> 7) & ~FileA)) >> 8;
+    uint64_t backward = ours & ~isolated & ~supported & guarded;
+
+    Score score = Doubled * doubled + Isolated * __builtin_popcountll(isolated) +
+                  Backward * __builtin_popcountll(backward);
+    for (int row = 1; row < 7; row++)
+    {
+      score += Passed[us == WHITE ? 7 - row : row] * __builtin_popcountll(passed & (0xFFULL << (8 * row)));
+    }
+    return score;
+  }
+
+  // Own pawns on the three files around the king, one and two rows ahead
+  int shieldBonus(Color us, uint64_t king, uint64_t pawns)
+  {
+    if (!king)
+    {
+      return 0;
+    }
+    int square = __builtin_ctzll(king);
+    int row = square / 8, file = square % 8;
+
+    // Only a king still on its first two rows is sheltered by pawns
+    if (us == WHITE ? row < 6 : row > 1)
+    {
+      return 0;
+    }
+
+    uint64_t files = (FileA << file) | adjacentFiles(file);
+    int step = us == WHITE ? -1 : 1;
+    uint64_t near = files & (0xFFULL << (8 * (row + step)));
+    int farRow = row + 2 * step;
+    uint64_t far = farRow >= 0 && farRow < 8 ? files & (0xFFULL << (8 * farRow)) : 0;
+    return ShieldNear * __builtin_popcountll(pawns & near) + ShieldFar * __builtin_popcountll(pawns & far);
+  }
+}
+
+Score evaluatePawns(uint64_t whitePawns, uint64_t blackPawns)
+{
+  return evaluateSide(WHITE, whitePawns, blackPawns) - evaluateSide(BLACK, blackPawns, whitePawns);
+}
+
+Score evaluatePawnShield(const Bitboards &board)
+{
+  return evaluatePawnShield(board.whitePawns, board.blackPawns, board.whiteKings, board.blackKings);
+}
+
+Score evaluatePawnShield(uint64_t whitePawns, uint64_t blackPawns, uint64_t whiteKing, uint64_t blackKing)
+{
+  return makeScore(shieldBonus(WHITE, whiteKing, whitePawns) - shieldBonus(BLACK, blackKing, blackPawns), 0);
+}
+
+PawnTable::PawnTable() : probes(0), hits(0), entries(new Entry[Size])
+{
+  // An empty entry matches the key of a board without pawns, whose score is 0
+  for (size_t i = 0; i < Size; i++)
+  {
+    entries[i] = Entry{0, 0};
+  }
+}
+
+Score PawnTable::probe(const Bitboards &board)
+{
+  Entry &entry = entries[board.pawnKey & (Size - 1)];
+  probes++;
+  if (entry.key == board.pawnKey)
+  {
+    hits++;
+    return entry.score;
+  }
+
+  entry.key = board.pawnKey;
+  entry.score = evaluatePawns(board.whitePawns, board.blackPawns);
+  return entry.score;
+}
@@ -0,0 +1,60 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "psqt.h"
+
+class Bitboards;
+
+// Pawn structure penalties and bonuses, packed middlegame/endgame. The
+// batch evaluator's vector kernel scores the same terms, from these values.
+namespace PawnTerms
+{
+  const Score Doubled = makeScore(-10, -20);  // Per extra pawn on a file
+  const Score Isolated = makeScore(-10, -15); // No own pawn on either neighbouring file
+  const Score Backward = makeScore(-8, -10);  // Cannot advance safely and no pawn can come to defend it
+
+  // Passed pawn bonus by rank from the owner's side (index 1 = second rank)
+  const Score Passed[8] = {
+      makeScore(0, 0), makeScore(5, 10), makeScore(10, 20), makeScore(20, 40),
+      makeScore(35, 70), makeScore(60, 120), makeScore(100, 200), makeScore(0, 0)};
+}
+
+// Doubled, isolated, backward and passed pawn terms for both sides, from
+// white's point of view. Depends on nothing but the two pawn sets. Each
+// term is worked out for all pawns of a side at once with shifts and masks.
+Score evaluatePawns(uint64_t whitePawns, uint64_t blackPawns);
+
+// Middlegame bonus for own pawns standing in front of each king, from
+// white's point of view
+Score evaluatePawnShield(const Bitboards &board);
+Score evaluatePawnShield(uint64_t whitePawns, uint64_t blackPawns, uint64_t whiteKing, uint64_t blackKing);
+
+// Cache of evaluatePawns keyed by Bitboards::pawnKey. Pawn structures
+// repeat across most of a search tree, so nearly every lookup hits.
+// Not thread-safe: each search thread owns one.
+class PawnTable
+{
+public:
+  PawnTable();
+
+  Score probe(const Bitboards &board);
+
+  uint64_t probes;
+  uint64_t hits;
+
+private:
+  struct Entry
+  {
+    uint64_t key;
+    Score score;
+  };
+
+  static const size_t Size = 1 << 14; // Entries; a power of two
+
+  std::unique_ptr<Entry[]> entries;
+};
+
+#endif // PAWNS_H
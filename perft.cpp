@@ -0,0 +1,162 @@
+#include "perft.h"
+#include "moves.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+  struct PerftPosition
+  {
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+  };
+
+  // Positions and counts from the Chess Programming Wiki "Perft Results" page
+  const PerftPosition ReferencePositions[] = {
+      {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+      {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+      {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+      {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+      {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+      {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+  };
+
+  double secondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Depth of the incremental state check in runPerftSuite: every position
+  // this deep is rescanned, so it is kept shallower than the counts
+  const int ConsistencyDepth = 3;
+
+  // Plays every move sequence 'depth' plies deep and checks the board's
+  // incremental state after each make and unmake
+  bool staysConsistent(Bitboards &board, int depth)
+  {
+    if (depth == 0)
+    {
+      return true;
+    }
+    UndoInfo undo;
+    for (PackedMove m : generateLegalMoves(board, board.whiteToMove))
+    {
+      board.makeMove(m, undo);
+      bool consistent = board.isConsistent() && staysConsistent(board, depth - 1);
+      board.unmakeMove(m, undo);
+      if (!consistent || !board.isConsistent())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void printSpeed(uint64_t nodes, double seconds)
+  {
+    std::cout << "Nodes: " << nodes << "\n"
+              << "Time: " << seconds << " s\n"
+              << "NPS: " << uint64_t(seconds > 0 ? nodes / seconds : 0) << std::endl;
+  }
+}
+
+uint64_t perft(Bitboards &board, int depth)
+{
+  if (depth == 0)
+  {
+    return 1;
+  }
+
+  MoveList moves = generateLegalMoves(board, board.whiteToMove);
+  if (depth == 1)
+  {
+    return moves.size(); // Every generated move is legal, so no need to play them
+  }
+
+  uint64_t nodes = 0;
+  UndoInfo undo;
+  for (PackedMove m : moves)
+  {
+    board.makeMove(m, undo);
+#ifdef BOARD_DEBUG
+    assert(board.isConsistent());
+#endif
+    nodes += perft(board, depth - 1);
+    board.unmakeMove(m, undo);
+#ifdef BOARD_DEBUG
+    assert(board.isConsistent());
+#endif
+  }
+  return nodes;
+}
+
+uint64_t runPerft(Bitboards &board, int depth)
+{
+  auto start = std::chrono::steady_clock::now();
+  uint64_t nodes = perft(board, depth);
+  printSpeed(nodes, secondsSince(start));
+  return nodes;
+}
+
+uint64_t divide(Bitboards &board, int depth)
+{
+  auto start = std::chrono::steady_clock::now();
+  uint64_t total = 0;
+
+  UndoInfo undo;
+  for (PackedMove m : generateLegalMoves(board, board.whiteToMove))
+  {
+    board.makeMove(m, undo);
+    uint64_t nodes = depth > 1 ? perft(board, depth - 1) : 1;
+    board.unmakeMove(m, undo);
+
+    std::cout << moveToString(m) << ": " << nodes << "\n";
+    total += nodes;
+  }
+
+  std::cout << "\n";
+  printSpeed(total, secondsSince(start));
+  return total;
+}
+
+bool runPerftSuite()
+{
+  auto start = std::chrono::steady_clock::now();
+  uint64_t totalNodes = 0;
+  bool allPassed = true;
+
+  for (const PerftPosition &position : ReferencePositions)
+  {
+    Bitboards board;
+    board.initialize(position.fen);
+
+    auto positionStart = std::chrono::steady_clock::now();
+    uint64_t nodes = perft(board, position.depth);
+    double seconds = secondsSince(positionStart);
+    bool consistent = staysConsistent(board, ConsistencyDepth);
+    bool passed = nodes == position.nodes && consistent;
+
+    std::cout << (passed ? "ok   " : "FAIL ") << position.name << " depth " << position.depth
+              << ": " << nodes;
+    if (nodes != position.nodes)
+    {
+      std::cout << " (expected " << position.nodes << ")";
+    }
+    if (!consistent)
+    {
+      std::cout << " (incremental state diverged)";
+    }
+    std::cout << ", " << uint64_t(seconds > 0 ? nodes / seconds : 0) << " nps\n";
+
+    totalNodes += nodes;
+    allPassed = allPassed && passed;
+  }
+
+  std::cout << "\n";
+  printSpeed(totalNodes, secondsSince(start));
+  std::cout << (allPassed ? "All perft counts match" : "Perft count mismatch") << std::endl;
+  return allPassed;
+}
@@ -0,0 +1,26 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <cstdint>
+#include "bitboards.h"
+
+// Counts the leaf nodes of the move generation tree 'depth' plies deep.
+// Used to check move generation against known node counts. The last ply
+// is counted from the length of the move list instead of being played.
+uint64_t perft(Bitboards &board, int depth);
+
+// Times perft and prints the node count and nodes/second
+uint64_t runPerft(Bitboards &board, int depth);
+
+// perft split by root move: prints each move with its own count, then the
+// total, node count and speed. Returns the total.
+uint64_t divide(Bitboards &board, int depth);
+
+// Runs perft on the standard reference positions and compares against their
+// published counts, and checks the board's incremental keys and scores
+// against a rescan over the first few plies. Prints one line per position
+// plus overall nodes/second. Returns true if every count matched and the
+// board stayed consistent.
+bool runPerftSuite();
+
+#endif // PERFT_H
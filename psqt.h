@@ -0,0 +1,164 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <cstdint>
+#include "types.h"
+
+// A middlegame and an endgame value packed into one int32: the endgame
+// half in the upper 16 bits, the middlegame half in the lower. Packed
+// scores add and negate as plain integers, so one add updates both halves.
+typedef int32_t Score;
+
+constexpr Score makeScore(int mg, int eg)
+{
+  return Score(uint32_t(eg) << 16) + mg;
+}
+
+constexpr int mgValue(Score score)
+{
+  return int16_t(uint16_t(uint32_t(score)));
+}
+
+// The + 0x8000 undoes the borrow a negative middlegame half takes from the endgame half
+constexpr int egValue(Score score)
+{
+  return int16_t(uint16_t((uint32_t(score) + 0x8000) >> 16));
+}
+
+// Game phase: the non-pawn material left, 24 with all pieces on the board
+constexpr int PhaseWeight[7] = {0, 0, 1, 1, 2, 4, 0}; // By PieceType
+constexpr int MaxPhase = 24;
+
+// Material plus piece-square values in centipawns, from white's point of
+// view, for white pieces. Row 0 is rank 8. Black uses the same tables
+// mirrored vertically.
+constexpr int16_t PawnMG[64] = {
+    900, 900, 900, 900, 900, 900, 900, 900,
+    130, 130, 130, 130, 130, 130, 130, 130,
+    120, 120, 120, 120, 120, 120, 120, 120,
+    120, 120, 120, 120, 120, 120, 120, 120,
+    110, 110, 120, 120, 120, 120, 110, 110,
+    110, 110, 110, 110, 110, 110, 110, 110,
+    100, 100, 100, 100, 100, 100, 100, 100,
+    0, 0, 0, 0, 0, 0, 0, 0};
+
+// Passed or not, an advanced pawn is worth much more once pieces are off
+constexpr int16_t PawnEG[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    200, 200, 200, 200, 200, 200, 200, 200,
+    160, 160, 160, 160, 160, 160, 160, 160,
+    135, 135, 135, 135, 135, 135, 135, 135,
+    120, 120, 120, 120, 120, 120, 120, 120,
+    110, 110, 110, 110, 110, 110, 110, 110,
+    105, 105, 105, 105, 105, 105, 105, 105,
+    0, 0, 0, 0, 0, 0, 0, 0};
+
+constexpr int16_t KnightMG[64] = {
+    250, 250, 270, 270, 270, 270, 250, 250,
+    250, 270, 300, 300, 300, 300, 270, 250,
+    270, 300, 300, 300, 300, 300, 300, 270,
+    300, 300, 300, 330, 330, 300, 300, 300,
+    300, 300, 300, 330, 330, 300, 300, 300,
+    270, 300, 330, 300, 300, 330, 300, 270,
+    250, 270, 300, 300, 300, 300, 270, 250,
+    250, 250, 270, 270, 270, 270, 250, 250};
+
+constexpr int16_t KnightEG[64] = {
+    260, 270, 280, 280, 280, 280, 270, 260,
+    270, 280, 290, 290, 290, 290, 280, 270,
+    280, 290, 300, 305, 305, 300, 290, 280,
+    280, 290, 305, 310, 310, 305, 290, 280,
+    280, 290, 305, 310, 310, 305, 290, 280,
+    280, 290, 300, 305, 305, 300, 290, 280,
+    270, 280, 290, 290, 290, 290, 280, 270,
+    260, 270, 280, 280, 280, 280, 270, 260};
+
+constexpr int16_t BishopMG[64] = {
+    300, 300, 300, 300, 300, 300, 300, 300,
+    300, 300, 300, 300, 300, 300, 300, 300,
+    300, 300, 300, 300, 300, 300, 300, 300,
+    300, 320, 300, 300, 300, 300, 320, 300,
+    300, 300, 320, 300, 300, 320, 300, 300,
+    300, 300, 300, 300, 300, 300, 300, 300,
+    300, 320, 300, 300, 300, 300, 320, 300,
+    300, 300, 300, 300, 300, 300, 300, 300};
+
+constexpr int16_t BishopEG[64] = {
+    290, 295, 295, 295, 295, 295, 295, 290,
+    295, 300, 300, 300, 300, 300, 300, 295,
+    295, 300, 305, 305, 305, 305, 300, 295,
+    295, 300, 305, 310, 310, 305, 300, 295,
+    295, 300, 305, 310, 310, 305, 300, 295,
+    295, 300, 305, 305, 305, 305, 300, 295,
+    295, 300, 300, 300, 300, 300, 300, 295,
+    290, 295, 295, 295, 295, 295, 295, 290};
+
+// Rooks and queens: flat except a rook on the seventh rank
+constexpr int16_t RookMG[64] = {
+    500, 500, 500, 500, 500, 500, 500, 500,
+    520, 520, 520, 520, 520, 520, 520, 520,
+    500, 500, 500, 500, 500, 500, 500, 500,
+    500, 500, 500, 500, 500, 500, 500, 500,
+    500, 500, 500, 500, 500, 500, 500, 500,
+    500, 500, 500, 500, 500, 500, 500, 500,
+    500, 500, 500, 500, 500, 500, 500, 500,
+    500, 500, 500, 500, 500, 500, 500, 500};
+
+constexpr int16_t RookEG = 520;
+constexpr int16_t QueenMG = 900;
+constexpr int16_t QueenEG = 930;
+
+// The king hides behind its pawns while queens and rooks are around...
+constexpr int16_t KingMG[64] = {
+    -60, -70, -70, -80, -80, -70, -70, -60,
+    -60, -70, -70, -80, -80, -70, -70, -60,
+    -60, -70, -70, -80, -80, -70, -70, -60,
+    -60, -70, -70, -80, -80, -70, -70, -60,
+    -40, -50, -50, -60, -60, -50, -50, -40,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    10, 10, 0, -10, -10, 0, 10, 10,
+    20, 30, 10, 0, 0, 10, 30, 20};
+
+// ...and heads for the center in the endgame
+constexpr int16_t KingEG[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10, 0, 0, -10, -20, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -30, 0, 0, 0, 0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50};
+
+// Signed packed value of every Piece on every square: positive for white
+// pieces, negative for black ones, so a position's score is a plain sum
+struct PieceSquareTable
+{
+  Score values[16][64];
+};
+
+constexpr PieceSquareTable makePieceSquareTable()
+{
+  PieceSquareTable table{};
+  for (int square = 0; square < 64; square++)
+  {
+    Score white[7] = {0,
+                      makeScore(PawnMG[square], PawnEG[square]),
+                      makeScore(KnightMG[square], KnightEG[square]),
+                      makeScore(BishopMG[square], BishopEG[square]),
+                      makeScore(RookMG[square], RookEG),
+                      makeScore(QueenMG, QueenEG),
+                      makeScore(KingMG[square], KingEG[square])};
+    for (int type = PAWN; type <= KING; type++)
+    {
+      table.values[makePiece(WHITE, PieceType(type))][square] = white[type];
+      // square ^ 56 flips the row, so black reads the white value of the mirrored square
+      table.values[makePiece(BLACK, PieceType(type))][square ^ 56] = -white[type];
+    }
+  }
+  return table;
+}
+
+inline constexpr PieceSquareTable PSQT = makePieceSquareTable();
+
+#endif // PSQT_H
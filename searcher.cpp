@@ -1,9 +1,376 @@
 #include "searcher.h"
+#include "book.h"
 #include "evaluation.h"
+#include "movepick.h"
+#include "tt.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
 
-// Forward declaration of alphaBeta or any helper function if needed.
+// Behind the free functions: the engine, UCI and bench search one position at a time
+static Searcher sharedSearcher;
+
+void setSearchThreads(int count)
+{
+  sharedSearcher.threadCount = std::max(1, count);
+}
+
+int searchThreads()
+{
+  return sharedSearcher.threadCount;
+}
+
+void setIterationCallback(IterationCallback callback)
+{
+  sharedSearcher.iterationCallback = callback;
+}
+
+// The main thread may only stop once it has a move to return; helpers
+// stop as soon as they are told to
+static bool shouldStop(const SearchThread &thread)
+{
+  return thread.searcher->stopped.load(std::memory_order_relaxed) && (thread.id != 0 || !thread.rootBestMove.isNull());
+}
+
+const SearchStats &lastSearchStats()
+{
+  return sharedSearcher.stats;
+}
+
+double effectiveBranchingFactor(const SearchStats &stats, int depth)
+{
+  if (depth < 2 || depth > MaxDepth || !stats.iterations[depth - 1].nodes)
+  {
+    return 0;
+  }
+  return double(stats.iterations[depth].nodes) / stats.iterations[depth - 1].nodes;
+}
+
+std::string searchStatsJson(const SearchStats &stats)
+{
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\"depth\":" << stats.depth << ",\"score\":" << stats.score << ",\"timeMs\":" << stats.elapsedMs
+      << ",\"nodes\":" << stats.nodes << ",\"qnodes\":" << stats.qnodes
+      << ",\"nps\":" << (stats.elapsedMs > 0 ? stats.nodes * 1000 / stats.elapsedMs : 0)
+      << ",\"ttProbes\":" << stats.ttProbes << ",\"ttHits\":" << stats.ttHits << ",\"ttCutoffs\":" << stats.ttCutoffs
+      << ",\"betaCutoffs\":" << stats.betaCutoffs << ",\"firstMoveCutoffs\":" << stats.firstMoveCutoffs
+      << ",\"pawnProbes\":" << stats.pawnProbes << ",\"pawnHits\":" << stats.pawnHits
+      << ",\"threads\":" << stats.threads << ",\"iterations\":[";
+
+  bool first = true;
+  for (int depth = 1; depth <= MaxDepth; depth++)
+  {
+    const IterationStats &it = stats.iterations[depth];
+    if (!it.nodes)
+    {
+      continue;
+    }
+    out << (first ? "" : ",") << "{\"depth\":" << depth << ",\"completed\":" << (it.completed ? "true" : "false")
+        << ",\"timeMs\":" << it.elapsedMs << ",\"nodes\":" << it.nodes << ",\"qnodes\":" << it.qnodes
+        << ",\"ebf\":" << effectiveBranchingFactor(stats, depth)
+        << ",\"ttProbes\":" << it.ttProbes << ",\"ttHits\":" << it.ttHits << ",\"ttCutoffs\":" << it.ttCutoffs
+        << ",\"betaCutoffs\":" << it.betaCutoffs << ",\"firstMoveCutoffs\":" << it.firstMoveCutoffs
+        << ",\"firstMoveCutoffRate\":" << (it.betaCutoffs ? double(it.firstMoveCutoffs) / it.betaCutoffs : 0.0)
+        << "}";
+    first = false;
+  }
+  out << "]}";
+  return out.str();
+}
+
+// Time manager. The optimum is what a move should normally take: no new
+// iteration starts after half of it, since the next one would likely not
+// finish. The maximum aborts an iteration in progress.
+static void allocateTime(Searcher &searcher)
+{
+  const SearchLimits &limits = searcher.limits;
+  int64_t &optimumMs = searcher.optimumMs, &maximumMs = searcher.maximumMs;
+  optimumMs = maximumMs = 0;
+  if (limits.moveTimeMs)
+  {
+    optimumMs = maximumMs = limits.moveTimeMs;
+  }
+  else if (limits.timeMs)
+  {
+    // Plan for the moves left before the next time control, or for 30
+    // more if the clock covers the rest of the game, keeping a margin for
+    // move overhead
+    int movesLeft = limits.movesToGo > 0 ? limits.movesToGo : 30;
+    int64_t available = std::max<int64_t>(limits.timeMs - 50, 1);
+    optimumMs = std::min(available / movesLeft + limits.incrementMs * 3 / 4, available);
+    maximumMs = std::min(optimumMs * 4, available);
+  }
+}
+
+static int64_t elapsedMs(const Searcher &searcher)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - searcher.start).count();
+}
+
+// Time the clock limits have been running: from the start of the search
+// or the last ponderhit, whichever is later, and none while pondering
+static int64_t clockMs(const Searcher &searcher)
+{
+  if (searcher.pondering)
+  {
+    return 0;
+  }
+  std::chrono::steady_clock::time_point ponderhitTime{std::chrono::steady_clock::duration(searcher.ponderhitTicks)};
+  std::chrono::steady_clock::time_point since = std::max(searcher.start, ponderhitTime);
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+void Searcher::ponderhit()
+{
+  ponderhitTicks = std::chrono::steady_clock::now().time_since_epoch().count();
+  pondering = false;
+}
+
+// Nodes searched so far by all of a search's threads
+static uint64_t nodesSearched(const Searcher &searcher)
+{
+  uint64_t nodes = 0;
+  for (const auto &thread : searcher.threads)
+  {
+    nodes += thread->nodes.load(std::memory_order_relaxed);
+  }
+  return nodes;
+}
+
+// Called by the main thread every few thousand nodes, so the clock is read rarely
+static void checkLimits(Searcher &searcher)
+{
+  if ((searcher.maximumMs && clockMs(searcher) >= searcher.maximumMs) ||
+      (searcher.limits.nodes && nodesSearched(searcher) >= searcher.limits.nodes))
+  {
+    searcher.stopped = true;
+  }
+}
+
+void stopSearch()
+{
+  sharedSearcher.stop();
+}
+
+void setPondering(bool pondering)
+{
+  sharedSearcher.pondering = pondering;
+}
+
+void ponderhit()
+{
+  sharedSearcher.ponderhit();
+}
+
+// Follows the table's best moves from the root, starting with 'first',
+// while they are legal and the line does not repeat a position
+static MoveList principalVariation(const TranspositionTable &tt, Bitboards board, PackedMove first, int maxLength)
+{
+  MoveList pv;
+  uint64_t seen[MaxPly];
+  PackedMove move = first;
+  while (!move.isNull() && int(pv.size()) < maxLength && isLegalMove(board, move))
+  {
+    seen[pv.size()] = board.key;
+    pv.push_back(move);
+    UndoInfo undo;
+    board.makeMove(move, undo);
+
+    TTHit hit;
+    move = tt.probe(board.key, hit, int(pv.size())) ? hit.move : PackedMove();
+    if (std::find(seen, seen + pv.size(), board.key) != seen + pv.size())
+    {
+      break;
+    }
+  }
+  return pv;
+}
+
+// Hands the main thread's finished iteration to the iteration callback
+static void reportIteration(const SearchThread &thread)
+{
+  const Searcher &searcher = *thread.searcher;
+  SearchStats progress = thread.stats;
+  progress.nodes = nodesSearched(searcher);
+  progress.elapsedMs = elapsedMs(searcher);
+  progress.threads = searcher.threadCount;
+  searcher.iterationCallback(progress, principalVariation(*searcher.tt, thread.board, thread.rootBestMove, thread.stats.depth));
+}
+
+// The counters 'now' gained since 'start'
+static IterationStats countedSince(const SearchStats &now, const SearchStats &start)
+{
+  IterationStats it = {};
+  it.nodes = now.nodes - start.nodes;
+  it.qnodes = now.qnodes - start.qnodes;
+  it.ttProbes = now.ttProbes - start.ttProbes;
+  it.ttHits = now.ttHits - start.ttHits;
+  it.ttCutoffs = now.ttCutoffs - start.ttCutoffs;
+  it.betaCutoffs = now.betaCutoffs - start.betaCutoffs;
+  it.firstMoveCutoffs = now.firstMoveCutoffs - start.firstMoveCutoffs;
+  return it;
+}
+
+// Iterative deepening on one thread. Helper threads start one ply deeper
+// on every other thread so they do not all search the same tree in
+// lockstep; what they find reaches the others through the table.
+static void iterativeDeepening(SearchThread &thread)
+{
+  // If it's white to move, we are maximizing from white's perspective.
+  // If it's black to move, we are maximizing from black's perspective but we can unify logic
+  // by simply setting maximizingPlayer = (board.whiteToMove).
+  const Searcher &searcher = *thread.searcher;
+  int maxDepth = searcher.limits.depth > 0 ? searcher.limits.depth : MaxDepth;
+  for (int depth = 1 + thread.id % 2; depth <= maxDepth; depth++)
+  {
+    PackedMove bestMove;
+    SearchStats start = thread.stats;
+    int64_t startMs = elapsedMs(searcher);
+    int score = alphaBeta(thread, depth, 0, -Infinity, Infinity, thread.board.whiteToMove, bestMove);
+
+    IterationStats &it = thread.stats.iterations[depth];
+    it = countedSince(thread.stats, start);
+    it.elapsedMs = elapsedMs(searcher) - startMs;
+    it.completed = !shouldStop(thread);
+
+    // An interrupted iteration is incomplete; keep the last finished one
+    if (!it.completed)
+    {
+      break;
+    }
+
+    thread.rootBestMove = bestMove;
+    thread.stats.depth = depth;
+    thread.stats.score = score;
+    if (thread.id == 0 && searcher.iterationCallback)
+    {
+      reportIteration(thread);
+    }
+
+    if (bestMove.isNull() ||
+        (thread.id == 0 && searcher.optimumMs && clockMs(searcher) >= searcher.optimumMs / 2))
+    {
+      break;
+    }
+  }
+}
+
+Move Searcher::findBestMove(const Bitboards &board, const SearchLimits &searchLimits)
+{
+  limits = searchLimits;
+  start = std::chrono::steady_clock::now();
+  allocateTime(*this);
+  stopped = false;
+  tt->newSearch();
+
+  // Threads are kept between searches so their pawn tables stay warm
+  if (threads.size() != size_t(threadCount))
+  {
+    threads.clear();
+    for (int i = 0; i < threadCount; i++)
+    {
+      threads.emplace_back(new SearchThread());
+      threads.back()->id = i;
+      threads.back()->searcher = this;
+    }
+  }
+  for (const auto &thread : threads)
+  {
+    thread->board = board;
+    thread->stats = SearchStats();
+    thread->nodes = 0;
+    thread->rootBestMove = PackedMove();
+    thread->pawns.probes = thread->pawns.hits = 0;
+    if (ActiveEvaluator == NNUE_EVAL)
+    {
+      refreshAccumulator(board, thread->stack[0].accumulator);
+    }
+    for (StackEntry &entry : thread->stack)
+    {
+      entry.killers[0] = entry.killers[1] = PackedMove();
+    }
+    std::fill(&thread->history[0][0][0], &thread->history[0][0][0] + 2 * 64 * 64, 0);
+  }
+
+  // Helpers run until the main thread finishes and stops them
+  std::vector<std::thread> helpers;
+  for (int i = 1; i < threadCount; i++)
+  {
+    helpers.emplace_back(iterativeDeepening, std::ref(*threads[i]));
+  }
+  iterativeDeepening(*threads[0]);
+  stopped = true;
+  for (std::thread &helper : helpers)
+  {
+    helper.join();
+  }
+
+  // Take the move of the deepest finished iteration, preferring the main thread
+  const SearchThread *best = threads[0].get();
+  stats = SearchStats();
+  for (const auto &thread : threads)
+  {
+    if (thread->stats.depth > best->stats.depth && !thread->rootBestMove.isNull())
+    {
+      best = thread.get();
+    }
+    stats.nodes += thread->stats.nodes;
+    stats.qnodes += thread->stats.qnodes;
+    stats.ttProbes += thread->stats.ttProbes;
+    stats.ttHits += thread->stats.ttHits;
+    stats.ttCutoffs += thread->stats.ttCutoffs;
+    stats.betaCutoffs += thread->stats.betaCutoffs;
+    stats.firstMoveCutoffs += thread->stats.firstMoveCutoffs;
+    stats.pawnProbes += thread->pawns.probes;
+    stats.pawnHits += thread->pawns.hits;
+
+    for (int depth = 1; depth <= MaxDepth; depth++)
+    {
+      const IterationStats &from = thread->stats.iterations[depth];
+      IterationStats &to = stats.iterations[depth];
+      to.nodes += from.nodes;
+      to.qnodes += from.qnodes;
+      to.ttProbes += from.ttProbes;
+      to.ttHits += from.ttHits;
+      to.ttCutoffs += from.ttCutoffs;
+      to.betaCutoffs += from.betaCutoffs;
+      to.firstMoveCutoffs += from.firstMoveCutoffs;
+      to.elapsedMs = std::max(to.elapsedMs, from.elapsedMs);
+      to.completed = to.completed || from.completed;
+    }
+  }
+  stats.depth = best->stats.depth;
+  stats.score = best->stats.score;
+  stats.elapsedMs = elapsedMs(*this);
+  stats.threads = threadCount;
+  return toMove(best->rootBestMove);
+}
+
+Move findBestMove(Bitboards board, const SearchLimits &limits)
+{
+  // A book move needs no search; its statistics are all zero
+  PackedMove bookMove = probeBook(board);
+  if (!bookMove.isNull())
+  {
+    sharedSearcher.stats = SearchStats();
+    sharedSearcher.stats.threads = sharedSearcher.threadCount;
+    return toMove(bookMove);
+  }
+  return searchBestMove(board, limits);
+}
+
+Move searchBestMove(Bitboards board, const SearchLimits &limits)
+{
+  return sharedSearcher.findBestMove(board, limits);
+}
 
-// Public function that your engine (or main program) calls to get the best move.
 Move findBestMove(Bitboards board, int depth)
 {
   // If depth <= 0, return an empty move (or some default).
@@ -12,56 +379,289 @@ Move findBestMove(Bitboards board, int depth)
     return Move{0, 0, ' ', false};
   }
 
-  // We call alphaBeta on the board. The side to move is determined by board.whiteToMove.
-  Move bestMove;
-  // If it's white to move, we are maximizing from white's perspective.
-  // If it's black to move, we are maximizing from black's perspective but we can unify logic
-  // by simply setting maximizingPlayer = (board.whiteToMove).
-  double bestScore = alphaBeta(board, depth, -std::numeric_limits<double>::infinity(),
-                               std::numeric_limits<double>::infinity(),
-                               board.whiteToMove, bestMove);
+  SearchLimits limits = {};
+  limits.depth = depth;
+  return findBestMove(board, limits);
+}
 
-  // bestMove is filled by alphaBeta
-  return bestMove;
+// Counts a node and checks the limits. True if the search must unwind;
+// the score then returned is never used.
+static bool visitNode(SearchThread &thread)
+{
+  uint64_t nodes = ++thread.stats.nodes;
+  thread.nodes.store(nodes, std::memory_order_relaxed);
+  if (thread.id == 0 && (nodes & 2047) == 0)
+  {
+    checkLimits(*thread.searcher);
+  }
+  return shouldStop(thread);
+}
+
+// Piece values in centipawns for delta pruning, by PieceType
+static const int PieceValue[7] = {0, 100, 300, 300, 500, 900, 0};
+
+// Material a capture or promotion wins, ignoring any recapture
+static int captureGain(const Bitboards &board, PackedMove move)
+{
+  int gain = move.isEnPassant() ? PieceValue[PAWN] : PieceValue[typeOf(board.pieceAt(move.targetSquare()))];
+  if (move.isPromotion())
+  {
+    gain += PieceValue[move.promotionType()] - PieceValue[PAWN];
+  }
+  return gain;
+}
+
+// Insertion sort by descending score: the lists are short, and moves with
+// equal scores keep their generation order
+static void sortMoves(MoveList &moves, int scores[])
+{
+  for (size_t i = 1; i < moves.size(); i++)
+  {
+    PackedMove m = moves[i];
+    int score = scores[i];
+    size_t j = i;
+    for (; j > 0 && scores[j - 1] < score; j--)
+    {
+      moves[j] = moves[j - 1];
+      scores[j] = scores[j - 1];
+    }
+    moves[j] = m;
+    scores[j] = score;
+  }
+}
+
+// Cutoff counts are capped so they cannot overflow in long searches
+static const int HistoryMax = 1 << 20;
+
+// Bookkeeping for a beta cutoff by the 'movesSearched'-th move: a quiet
+// move becomes a killer for this ply and is credited in the history table
+static void recordCutoff(SearchThread &thread, int ply, PackedMove move, int depth, int movesSearched)
+{
+  thread.stats.betaCutoffs++;
+  if (movesSearched == 1)
+  {
+    thread.stats.firstMoveCutoffs++;
+  }
+
+  if (move.isCapture() || move.isPromotion())
+  {
+    return;
+  }
+
+  PackedMove(&killers)[2] = thread.stack[ply].killers;
+  if (killers[0] != move)
+  {
+    killers[1] = killers[0];
+    killers[0] = move;
+  }
+
+  int &entry = thread.history[thread.board.whiteToMove ? WHITE : BLACK][move.sourceSquare()][move.targetSquare()];
+  entry = std::min(entry + depth * depth, HistoryMax);
+}
+
+// Plays 'move' at 'ply' and brings the next ply's accumulator up to date
+static void playMove(SearchThread &thread, int ply, PackedMove move)
+{
+  StackEntry &entry = thread.stack[ply];
+  thread.board.makeMove(move, entry.undo);
+  if (ActiveEvaluator == NNUE_EVAL)
+  {
+    updateAccumulator(entry.accumulator, thread.stack[ply + 1].accumulator, thread.board, move,
+                      entry.undo.capturedPiece);
+  }
+}
+
+static int evaluate(SearchThread &thread, int ply)
+{
+  if (ActiveEvaluator == NNUE_EVAL)
+  {
+    return evaluateNnue(thread.board, thread.stack[ply].accumulator);
+  }
+  return evaluateBoard(thread.board, thread.pawns);
+}
+
+// Only captures that could bring the score back within this much of the
+// window are searched in quiescence
+static const int DeltaMargin = 200;
+
+// Resolves captures at the leaves so positions are only evaluated when
+// quiet. The side to move may "stand pat" on the static evaluation instead
+// of capturing, except when in check, where every evasion is searched.
+int quiescence(SearchThread &thread, int ply, int alpha, int beta, bool maximizingPlayer)
+{
+  Bitboards &board = thread.board;
+  thread.stats.qnodes++;
+  if (visitNode(thread))
+  {
+    return 0;
+  }
+
+  bool inCheck = board.inCheck();
+  if (ply >= MaxPly - 1)
+  {
+    return evaluate(thread, ply);
+  }
+
+  int standPat = 0;
+  if (!inCheck)
+  {
+    standPat = evaluate(thread, ply);
+    if (maximizingPlayer)
+    {
+      if (standPat >= beta)
+        return standPat;
+      alpha = std::max(alpha, standPat);
+    }
+    else
+    {
+      if (standPat <= alpha)
+        return standPat;
+      beta = std::min(beta, standPat);
+    }
+  }
+
+  MoveList moves = inCheck ? generateLegalMoves(board, board.whiteToMove)
+                           : generateCaptures(board, board.whiteToMove);
+  if (moves.empty())
+  {
+    if (inCheck)
+      return maximizingPlayer ? -(MateScore - ply) : MateScore - ply;
+    return standPat;
+  }
+
+  int scores[MoveList::Capacity];
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    scores[i] = moves[i].isCapture() || moves[i].isPromotion() ? mvvLva(board, moves[i]) : 0;
+  }
+  sortMoves(moves, scores);
+
+  int bestEval = inCheck ? (maximizingPlayer ? -Infinity : Infinity) : standPat;
+  UndoInfo &undo = thread.stack[ply].undo;
+  for (PackedMove m : moves)
+  {
+    // Delta pruning: even winning the piece outright would not reach the window
+    if (!inCheck)
+    {
+      int best = captureGain(board, m) + DeltaMargin;
+      if (maximizingPlayer ? standPat + best <= alpha : standPat - best >= beta)
+      {
+        continue;
+      }
+    }
+
+    playMove(thread, ply, m);
+    int score = quiescence(thread, ply + 1, alpha, beta, !maximizingPlayer);
+    board.unmakeMove(m, undo);
+
+    if (shouldStop(thread))
+    {
+      return 0;
+    }
+
+    if (maximizingPlayer)
+    {
+      bestEval = std::max(bestEval, score);
+      alpha = std::max(alpha, bestEval);
+    }
+    else
+    {
+      bestEval = std::min(bestEval, score);
+      beta = std::min(beta, bestEval);
+    }
+    if (beta <= alpha)
+    {
+      break;
+    }
+  }
+  return bestEval;
 }
 
 // Minimax with alpha-beta pruning
-double alphaBeta(Bitboards &board, int depth, double alpha, double beta, bool maximizingPlayer, Move &outBestMove)
+int alphaBeta(SearchThread &thread, int depth, int ply, int alpha, int beta, bool maximizingPlayer, PackedMove &outBestMove)
 {
-  // Base case: if depth = 0, return the static evaluation of this position.
+  Bitboards &board = thread.board;
+  SearchStats &stats = thread.stats;
+  TranspositionTable &tt = *thread.searcher->tt;
+
+  // Base case: at depth 0 the captures are played out by quiescence.
   // 'outBestMove' need not be changed, because at depth 0 there's no move to make.
   if (depth == 0)
   {
-    return evaluateBoard(board);
+    return quiescence(thread, ply, alpha, beta, maximizingPlayer);
   }
 
-  // Generate all moves for side to move (whiteToMove).
-  std::vector<Move> moves = generateLegalMoves(board, board.whiteToMove);
+  // Stop as soon as a limit is hit. The returned score is never used.
+  if (visitNode(thread))
+  {
+    return 0;
+  }
 
-  // If there are no moves, it could be checkmate or stalemate. Let's do a basic check:
-  if (moves.empty())
+  // A stored result from at least this depth can settle the node outright.
+  // Either way its best move is worth searching first.
+  int alphaOrig = alpha;
+  int betaOrig = beta;
+  PackedMove hashMove;
+  TTHit hit;
+  stats.ttProbes++;
+  if (tt.probe(board.key, hit, ply))
   {
-    // If it's check, let's return large negative or large positive score
-    //   but currently we do not fully check for "in-check". We'll assume "checkmate" = losing.
-    //   If you have a method to detect check or checkmate, you can refine this.
-    // In your Bitboards class, you have `checkmate` and `stalemate` flags, but they might not be reliable
-    //   if you haven't implemented them fully.
-    // For demonstration, let's simply penalize the side to move if it has no moves:
-    return maximizingPlayer ? -99999.0 : 99999.0;
+    stats.ttHits++;
+    hashMove = hit.move;
+    int ttScore = hit.score;
+    if (hit.depth >= depth && !hashMove.isNull() &&
+        (hit.bound == BOUND_EXACT ||
+         (hit.bound == BOUND_LOWER && ttScore >= beta) ||
+         (hit.bound == BOUND_UPPER && ttScore <= alpha)))
+    {
+      stats.ttCutoffs++;
+      outBestMove = hashMove;
+      return ttScore;
+    }
+  }
+
+  // At the root the previous iteration's best move goes first
+  if (ply == 0 && !thread.rootBestMove.isNull())
+  {
+    hashMove = thread.rootBestMove;
+  }
+
+  int color = board.whiteToMove ? WHITE : BLACK;
+  // Helpers vary their quiet move order as well as their start depth
+  MovePicker picker(board, hashMove, thread.stack[ply].killers, thread.history[color], thread.id);
+  PackedMove m = picker.next();
+
+  // No legal moves: checkmate if in check, otherwise stalemate
+  if (m.isNull())
+  {
+    if (!board.inCheck())
+    {
+      return 0;
+    }
+    return maximizingPlayer ? -(MateScore - ply) : MateScore - ply;
   }
 
   // We will store the best move found so far in a local variable.
-  Move bestMoveLocal = moves[0];
-  double bestEval = maximizingPlayer ? -std::numeric_limits<double>::infinity()
-                                     : std::numeric_limits<double>::infinity();
+  PackedMove bestMoveLocal = m;
+  int bestEval = maximizingPlayer ? -Infinity : Infinity;
+  int movesSearched = 0;
 
-  for (const auto &m : moves)
+  UndoInfo &undo = thread.stack[ply].undo;
+  for (; !m.isNull(); m = picker.next())
   {
-    // Simulate the move
-    Bitboards newBoard = board.simulateMove(m);
+    movesSearched++;
+    // Play the move on the board itself; it is taken back below
+    playMove(thread, ply, m);
+    tt.prefetch(board.key);
     // Recursively call alphaBeta with depth-1
-    Move dummyChildMove; // This will hold the best move for the child call, but we don't need it here.
-    double score = alphaBeta(newBoard, depth - 1, alpha, beta, !maximizingPlayer, dummyChildMove);
+    PackedMove dummyChildMove; // This will hold the best move for the child call, but we don't need it here.
+    int score = alphaBeta(thread, depth - 1, ply + 1, alpha, beta, !maximizingPlayer, dummyChildMove);
+    board.unmakeMove(m, undo);
+
+    if (shouldStop(thread))
+    {
+      return 0;
+    }
 
     // If we are maximizing, we look for the highest score.
     if (maximizingPlayer)
@@ -76,6 +676,7 @@ double alphaBeta(Bitboards &board, int depth, double alpha, double beta, bool ma
       // Alpha-beta cutoff
       if (beta <= alpha)
       {
+        recordCutoff(thread, ply, m, depth, movesSearched);
         break;
       }
     }
@@ -92,11 +693,19 @@ double alphaBeta(Bitboards &board, int depth, double alpha, double beta, bool ma
       // Alpha-beta cutoff
       if (beta <= alpha)
       {
+        recordCutoff(thread, ply, m, depth, movesSearched);
         break;
       }
     }
   }
 
+  // Scores are always from white's point of view, so the bound follows from
+  // the original window the same way at maximizing and minimizing nodes.
+  Bound bound = bestEval <= alphaOrig  ? BOUND_UPPER
+                : bestEval >= betaOrig ? BOUND_LOWER
+                                       : BOUND_EXACT;
+  tt.store(board.key, bestMoveLocal, bestEval, depth, bound, ply);
+
   // Write out the bestMove found in this node
   outBestMove = bestMoveLocal;
   return bestEval;
@@ -1,24 +1,204 @@
 #ifndef SEARCHER_H
 #define SEARCHER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <limits>
+#include <string>
 #include "bitboards.h"
 #include "moves.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "tt.h"
 
 // Holds a move and its evaluation score (for convenience)
 struct ScoredMove
 {
   Move move;
-  double score;
+  int score;
 };
 
+// When to stop searching. Zero means "no limit" for every field; with no
+// limits at all the search runs until stopSearch() is called.
+struct SearchLimits
+{
+  int depth;          // Deepest iteration to search, in plies
+  int64_t moveTimeMs; // Fixed time to spend on this move
+  int64_t timeMs;     // Clock time left for the side to move
+  int64_t incrementMs;
+  int movesToGo;      // Moves to play before the clock gets more time (0: rest of the game)
+  uint64_t nodes;
+};
+
+// Deepest iteration findBestMove runs
+const int MaxDepth = 64;
+
+// Counters of one iterative deepening iteration, summed over the threads
+// that searched that depth
+struct IterationStats
+{
+  uint64_t nodes;            // alphaBeta and quiescence calls
+  uint64_t qnodes;           // ... of which quiescence
+  uint64_t ttProbes;
+  uint64_t ttHits;
+  uint64_t ttCutoffs;
+  uint64_t betaCutoffs;
+  uint64_t firstMoveCutoffs;
+  int64_t elapsedMs; // Wall time, the longest of any thread
+  bool completed;    // False if the search stopped during it
+};
+
+// Counters collected while searching. Each thread counts into its own
+// copy; findBestMove sums them once the threads are done.
+struct SearchStats
+{
+  uint64_t nodes;     // alphaBeta and quiescence calls
+  uint64_t qnodes;    // ... of which quiescence
+  uint64_t ttProbes;  // Transposition table lookups
+  uint64_t ttHits;    // Lookups that found the position
+  uint64_t ttCutoffs; // Hits that ended the node without searching it
+  uint64_t betaCutoffs;      // Nodes left early because a move refuted the opponent's
+  uint64_t firstMoveCutoffs; // ... of which by the first move tried
+  uint64_t pawnProbes;       // Pawn structure lookups by the evaluation
+  uint64_t pawnHits;         // ... answered from the pawn hash table
+  int depth;          // Last fully searched iteration
+  int score;          // Its score in centipawns, from white's point of view
+  int64_t elapsedMs;
+  int threads;        // Threads that searched
+  IterationStats iterations[MaxDepth + 1]; // By depth; zero for depths not searched
+};
+
+// Counters of the last findBestMove call, summed over all threads
+const SearchStats &lastSearchStats();
+
+// Nodes of iteration 'depth' over those of the one before it (0 if
+// either is missing)
+double effectiveBranchingFactor(const SearchStats &stats, int depth);
+
+// 'stats' as one line of JSON, with an entry per iteration searched
+std::string searchStatsJson(const SearchStats &stats);
+
+// Plies a search can reach, bounding each thread's stack
+const int MaxPly = 128;
+
+// Scores are centipawns from white's point of view. White being mated
+// 'ply' plies from the root scores -(MateScore - ply), black MateScore - ply,
+// so nearer mates score higher. Anything beyond MateInMaxPly is a mate;
+// Infinity is beyond any score.
+const int MateScore = 99999;
+const int MateInMaxPly = MateScore - MaxPly;
+const int Infinity = 100000;
+
+// Per-ply state of one thread's search
+struct StackEntry
+{
+  UndoInfo undo;         // For taking back the move made at this ply
+  PackedMove killers[2]; // Quiet moves that recently caused cutoffs at this ply
+  Accumulator accumulator; // Network inputs of the position at this ply (NNUE only)
+};
+
+struct Searcher;
+
+// Everything one search thread writes while it searches. Threads share only
+// the transposition table and the stop flag; alignment keeps two threads'
+// data off the same cache line.
+struct alignas(64) SearchThread
+{
+  int id; // 0 is the main thread, which watches the limits
+  Searcher *searcher; // The search this thread belongs to
+  Bitboards board;
+  SearchStats stats;
+  std::atomic<uint64_t> nodes; // Read by the main thread for the node limit
+  PackedMove rootBestMove;     // Best move of the last finished iteration
+  StackEntry stack[MaxPly];
+
+  // Quiet move cutoff counts by [color][from][to], for move ordering
+  int history[2][64][64];
+
+  // Kept from one search to the next, as pawn structures carry over
+  PawnTable pawns;
+};
+
+// Called on the searching thread each time the main thread finishes an
+// iteration, with the counters so far (summed over threads) and the line
+// the table holds from the root. Null (the default) reports nothing.
+typedef void (*IterationCallback)(const SearchStats &stats, const MoveList &pv);
+
+// One search: its limits, its threads and the counters of its last run.
+// The free functions below use a single shared Searcher; code running
+// several searches at once gives each its own. Searchers use the global
+// transposition table unless given one of their own.
+struct Searcher
+{
+  // Searches depth 1, 2, 3... until a limit is hit and returns the best
+  // move of the last iteration that finished, for the side to move in 'board'
+  Move findBestMove(const Bitboards &board, const SearchLimits &limits);
+
+  // Makes a running findBestMove return as soon as it has a move. Safe to
+  // call from another thread.
+  void stop() { stopped = true; }
+
+  // While 'pondering' is set the search runs on the opponent's time and its
+  // clock limits wait. ponderhit() clears it and starts them from now (or
+  // from the start of the search, if that comes later). Safe to call from
+  // another thread.
+  void ponderhit();
+  std::atomic<bool> pondering{false};
+
+  int threadCount = 1; // Threads findBestMove searches with
+  TranspositionTable *tt = &TT; // Shared by this search's threads
+  IterationCallback iterationCallback = nullptr;
+  SearchStats stats = {}; // Counters of the last findBestMove call, summed over all threads
+
+  // State of the search in progress, shared by all its threads
+  SearchLimits limits = {};
+  std::chrono::steady_clock::time_point start;
+  int64_t optimumMs = 0, maximumMs = 0;
+  std::atomic<bool> stopped{false};
+  std::atomic<std::chrono::steady_clock::rep> ponderhitTicks{0}; // When ponderhit() was last called
+
+  // Kept between searches so their pawn tables stay warm
+  std::vector<std::unique_ptr<SearchThread>> threads;
+};
+
+// Number of threads findBestMove searches with (1 by default)
+void setSearchThreads(int count);
+int searchThreads();
+
 // The main interface to find the best move from a given board state.
-// 'depth' is measured in plies. The function will return the best move
-// for the side to move in the given 'board' state.
+// Plays from the opening book if one is loaded and has a move; otherwise
+// searches depth 1, 2, 3... until a limit is hit and returns the best move
+// of the last iteration that finished, for the side to move in 'board'.
+Move findBestMove(Bitboards board, const SearchLimits &limits);
+
+// Fixed-depth search; 'depth' is measured in plies
 Move findBestMove(Bitboards board, int depth);
 
-// Internal minimax with alpha-beta pruning.
-double alphaBeta(Bitboards &board, int depth, double alpha, double beta, bool maximizingPlayer, Move &bestMove);
+// findBestMove without the book: always searches. For benchmarks, whose
+// node counts must not depend on which book is loaded.
+Move searchBestMove(Bitboards board, const SearchLimits &limits);
+
+// Makes a running findBestMove return as soon as it has a move. Safe to
+// call from another thread.
+void stopSearch();
+
+// Whether the shared Searcher's searches ponder, and Searcher::ponderhit()
+// for it. Set pondering before starting the search it is meant for.
+void setPondering(bool pondering);
+void ponderhit();
+
+// Sets the shared Searcher's iteration callback
+void setIterationCallback(IterationCallback callback);
+
+// Internal minimax with alpha-beta pruning on thread.board. 'ply' is the
+// distance from the root.
+int alphaBeta(SearchThread &thread, int depth, int ply, int alpha, int beta, bool maximizingPlayer, PackedMove &bestMove);
+
+// Searches only captures and promotions (all evasions when in check) until
+// the position is quiet, then returns its static evaluation.
+int quiescence(SearchThread &thread, int ply, int alpha, int beta, bool maximizingPlayer);
 
 #endif // SEARCHER_H
@@ -0,0 +1,144 @@
+#include "tt.h"
+#include "searcher.h"
+
+TranspositionTable TT;
+
+namespace
+{
+  const size_t DefaultSizeMB = 16;
+
+  // Data word layout: move (16 bits) | score (32) | depth (8) | bound (2) | generation (6)
+  uint64_t packData(PackedMove move, int score, int depth, Bound bound, uint8_t generation)
+  {
+    return uint64_t(move.raw()) | (uint64_t(uint32_t(score)) << 16) | (uint64_t(uint8_t(depth)) << 48) |
+           (uint64_t(bound) << 56) | (uint64_t(generation & 63) << 58);
+  }
+
+  PackedMove dataMove(uint64_t data) { return PackedMove::fromRaw(uint16_t(data)); }
+  int dataScore(uint64_t data) { return int32_t(uint32_t(data >> 16)); }
+  int dataDepth(uint64_t data) { return uint8_t(data >> 48); }
+  Bound dataBound(uint64_t data) { return Bound((data >> 56) & 3); }
+  uint8_t dataGeneration(uint64_t data) { return uint8_t(data >> 58); }
+}
+
+TranspositionTable::TranspositionTable() : bucketCount(0), generation(0)
+{
+  resize(DefaultSizeMB);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+  size_t count = (megabytes << 20) / sizeof(Bucket);
+  if (count == 0)
+  {
+    count = 1;
+  }
+
+  buckets.reset(new Bucket[count]);
+  bucketCount = count;
+  clear();
+}
+
+void TranspositionTable::clear()
+{
+  for (size_t i = 0; i < bucketCount; i++)
+  {
+    for (Entry &e : buckets[i].entries)
+    {
+      e.check.store(0, std::memory_order_relaxed);
+      e.data.store(0, std::memory_order_relaxed);
+    }
+  }
+  generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+  generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+// A mate 'ply' plies from the root is that much nearer to the node
+static int scoreToTT(int score, int ply)
+{
+  return score >= MateInMaxPly ? score + ply : score <= -MateInMaxPly ? score - ply : score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+  return score >= MateInMaxPly ? score - ply : score <= -MateInMaxPly ? score + ply : score;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTHit &hit, int ply) const
+{
+  const Bucket &bucket = bucketFor(key);
+  for (const Entry &e : bucket.entries)
+  {
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    uint64_t check = e.check.load(std::memory_order_relaxed);
+    if ((check ^ data) == key && dataBound(data) != BOUND_NONE)
+    {
+      hit.move = dataMove(data);
+      hit.score = scoreFromTT(dataScore(data), ply);
+      hit.depth = dataDepth(data);
+      hit.bound = dataBound(data);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TranspositionTable::store(uint64_t key, PackedMove move, int score, int depth, Bound bound, int ply)
+{
+  Bucket &bucket = bucketFor(key);
+
+  // Reuse the entry for this position if there is one. Otherwise replace the
+  // least valuable entry: shallow results from old searches go first.
+  Entry *replace = &bucket.entries[0];
+  int worstValue = 1 << 30;
+  uint8_t current = generation.load(std::memory_order_relaxed) & 63;
+  for (Entry &e : bucket.entries)
+  {
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    uint64_t check = e.check.load(std::memory_order_relaxed);
+    if ((check ^ data) == key || dataBound(data) == BOUND_NONE)
+    {
+      if (move.isNull() && (check ^ data) == key)
+      {
+        move = dataMove(data); // Keep the old best move
+      }
+      replace = &e;
+      break;
+    }
+
+    int age = (current - dataGeneration(data)) & 63;
+    int value = dataDepth(data) - 8 * age;
+    if (value < worstValue)
+    {
+      worstValue = value;
+      replace = &e;
+    }
+  }
+
+  uint64_t data = packData(move, scoreToTT(score, ply), depth, bound, current);
+  replace->data.store(data, std::memory_order_relaxed);
+  replace->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const
+{
+  size_t sampled = bucketCount < 250 ? bucketCount : 250;
+  uint8_t current = generation.load(std::memory_order_relaxed) & 63;
+  int used = 0;
+  for (size_t i = 0; i < sampled; i++)
+  {
+    for (const Entry &e : buckets[i].entries)
+    {
+      uint64_t data = e.data.load(std::memory_order_relaxed);
+      if (dataBound(data) != BOUND_NONE && dataGeneration(data) == current)
+      {
+        used++;
+      }
+    }
+  }
+  return sampled ? int(used * 1000 / (sampled * 4)) : 0;
+}
@@ -0,0 +1,85 @@
+#ifndef TT_H
+#define TT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "moves.h"
+
+// How a stored score relates to the true value of the position
+enum Bound
+{
+  BOUND_NONE,
+  BOUND_UPPER, // Search failed low: true value <= score
+  BOUND_LOWER, // Search failed high: true value >= score
+  BOUND_EXACT,
+};
+
+// Contents of an entry found by TranspositionTable::probe
+struct TTHit
+{
+  PackedMove move;
+  int score;
+  int depth;
+  Bound bound;
+};
+
+// Hash table of search results keyed by Bitboards::key.
+// Memory is split into 64-byte (cache line) buckets of four 16-byte entries.
+// Each entry stores a data word (move, score, depth, bound, generation) and a
+// check word holding key ^ data. Entries are written without locks; a reader
+// only accepts an entry whose check ^ data gives back its key, so an entry
+// torn by two threads writing at once is simply treated as a miss.
+class TranspositionTable
+{
+public:
+  TranspositionTable();
+
+  // Reallocates the table with 'megabytes' of memory and clears it
+  void resize(size_t megabytes);
+  void clear();
+
+  // Starts a new search, so entries from older searches become replaceable
+  void newSearch();
+
+  // Mate scores count plies from the root; entries hold them counted from
+  // their own position instead, so 'ply' is the distance of 'key' from the
+  // root of the search storing or probing it.
+  bool probe(uint64_t key, TTHit &hit, int ply) const;
+  void store(uint64_t key, PackedMove move, int score, int depth, Bound bound, int ply);
+
+  // Pulls the bucket for 'key' into cache ahead of a probe
+  void prefetch(uint64_t key) const { __builtin_prefetch(&bucketFor(key)); }
+
+  // Permille of sampled entries written during the current search
+  int hashfull() const;
+
+  size_t sizeMB() const { return bucketCount * sizeof(Bucket) >> 20; }
+
+private:
+  struct Entry
+  {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+
+  struct alignas(64) Bucket
+  {
+    Entry entries[4];
+  };
+
+  Bucket &bucketFor(uint64_t key) const
+  {
+    // Maps the key onto [0, bucketCount) without requiring a power of two
+    return buckets[(unsigned __int128)key * bucketCount >> 64];
+  }
+
+  std::unique_ptr<Bucket[]> buckets;
+  size_t bucketCount;
+  std::atomic<uint8_t> generation; // Only its low 6 bits are stored; bumped by concurrent searches
+};
+
+extern TranspositionTable TT;
+
+#endif // TT_H
@@ -0,0 +1,44 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+enum PieceType
+{
+  NO_PIECE_TYPE,
+  PAWN,
+  KNIGHT,
+  BISHOP,
+  ROOK,
+  QUEEN,
+  KING,
+};
+
+enum Color
+{
+  WHITE,
+  BLACK,
+};
+
+// A colored piece: bits 0-2 hold the PieceType, bit 3 the Color
+enum Piece
+{
+  NO_PIECE,
+  WHITE_PAWN = PAWN, WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING,
+  BLACK_PAWN = PAWN + 8, BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING,
+};
+
+constexpr Piece makePiece(Color color, PieceType type)
+{
+  return Piece((color << 3) | type);
+}
+
+constexpr PieceType typeOf(Piece piece)
+{
+  return PieceType(piece & 7);
+}
+
+constexpr Color colorOf(Piece piece)
+{
+  return Color(piece >> 3);
+}
+
+#endif // TYPES_H
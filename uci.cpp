@@ -0,0 +1,273 @@
+#include "uci.h"
+#include "attacks.h"
+#include "bitboards.h"
+#include "moves.h"
+#include "searcher.h"
+#include "tt.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+  const char *StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+  // The search thread reports while the input loop answers commands
+  std::mutex outputMutex;
+
+  void send(const std::string &line)
+  {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+  }
+
+  // Side to move of the position being searched, for the score's sign
+  bool rootWhiteToMove = true;
+
+  void reportIteration(const SearchStats &stats, const MoveList &pv)
+  {
+    std::ostringstream line;
+    int score = rootWhiteToMove ? stats.score : -stats.score;
+    line << "info depth " << stats.depth << " score ";
+    if (score >= MateInMaxPly || score <= -MateInMaxPly)
+    {
+      // Mate scores fall by one per ply to the mate; UCI counts moves
+      int moves = (MateScore - std::abs(score) + 1) / 2;
+      line << "mate " << (score > 0 ? moves : -moves);
+    }
+    else
+    {
+      line << "cp " << score;
+    }
+    line << " nodes " << stats.nodes << " nps " << (stats.elapsedMs > 0 ? stats.nodes * 1000 / stats.elapsedMs : stats.nodes)
+         << " time " << stats.elapsedMs << " pv";
+    for (PackedMove move : pv)
+    {
+      line << " " << moveToUci(move);
+    }
+    send(line.str());
+  }
+
+  class Uci
+  {
+  public:
+    ~Uci() { waitForSearch(); }
+
+    // Returns false on "quit"
+    bool execute(const std::string &line)
+    {
+      std::istringstream in(line);
+      std::string command;
+      in >> command;
+
+      if (command == "uci")
+      {
+        send("id name Chess-Engine");
+        send("id author Gogo-XD");
+        send("option name Hash type spin default " + std::to_string(TT.sizeMB()) + " min 1 max 65536");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name Ponder type check default false");
+        send("option name StatsJson type check default false");
+        send(std::string("info string slider backend ") + sliderBackendName());
+        send("uciok");
+      }
+      else if (command == "isready")
+        send("readyok");
+      else if (command == "ucinewgame")
+      {
+        waitForSearch();
+        TT.clear();
+      }
+      else if (command == "position")
+        position(in);
+      else if (command == "go")
+        go(in);
+      else if (command == "stop")
+        waitForSearch();
+      else if (command == "ponderhit")
+      {
+        // The opponent played the expected move: the clock limits of "go
+        // ponder" run from now, and its bestmove is no longer held back
+        std::lock_guard<std::mutex> lock(searchMutex);
+        ponderhit();
+        holdBestMove = infiniteSearch;
+        searchChanged.notify_all();
+      }
+      else if (command == "setoption")
+        setOption(in);
+      else if (command == "quit")
+        return false;
+      else if (!command.empty())
+        send("info string unknown command " + command);
+      return true;
+    }
+
+  private:
+    Bitboards board;
+    std::thread worker;
+    bool statsJson = false; // Report each search's statistics before its bestmove
+
+    // Shared with the worker. A search started by "go infinite" holds its
+    // bestmove until told to stop, and one started by "go ponder" until
+    // "ponderhit" or "stop", even if it runs out of depth first.
+    std::mutex searchMutex;
+    std::condition_variable searchChanged;
+    bool holdBestMove = false;
+    bool infiniteSearch = false;
+    bool searchDone = false;
+
+    // Stops a running search; it still prints its bestmove
+    void waitForSearch()
+    {
+      if (!worker.joinable())
+      {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(searchMutex);
+      holdBestMove = false;
+      searchChanged.notify_all();
+      // The search clears the stop flag as it starts, so a stop sent just
+      // before that is lost; repeat it until the worker is done
+      while (!searchDone)
+      {
+        stopSearch();
+        searchChanged.wait_for(lock, std::chrono::milliseconds(1));
+      }
+      lock.unlock();
+      worker.join();
+    }
+
+    // position startpos|fen <fen> [moves <move>...]
+    void position(std::istringstream &in)
+    {
+      waitForSearch();
+      std::string token, fen;
+      in >> token;
+      if (token == "startpos")
+      {
+        fen = StartFen;
+        in >> token;
+      }
+      else if (token == "fen")
+      {
+        while (in >> token && token != "moves")
+        {
+          fen += (fen.empty() ? "" : " ") + token;
+        }
+      }
+      else
+      {
+        return;
+      }
+
+      // Whatever follows "moves" (already read) is the move list
+      board = Bitboards();
+      board.initialize(fen);
+      while (in >> token)
+      {
+        PackedMove move = parseMove(board, token);
+        if (move.isNull())
+        {
+          send("info string illegal move " + token);
+          break;
+        }
+        UndoInfo undo;
+        board.makeMove(move, undo);
+      }
+      board.updateAttacks();
+    }
+
+    // go [wtime|btime|winc|binc|movestogo|movetime|depth|nodes <n>]... [infinite|ponder]
+    void go(std::istringstream &in)
+    {
+      waitForSearch();
+      SearchLimits limits = {};
+      bool infinite = false, ponder = false;
+      std::string token;
+      long long value;
+      while (in >> token)
+      {
+        // "infinite" runs until "stop". "ponder" searches on the opponent's
+        // time; its clock values apply from "ponderhit" on.
+        if (token == "infinite" || token == "ponder")
+        {
+          infinite = infinite || token == "infinite";
+          ponder = ponder || token == "ponder";
+          continue;
+        }
+        if (!(in >> value))
+          break;
+        if (token == (board.whiteToMove ? "wtime" : "btime"))
+          limits.timeMs = value;
+        else if (token == (board.whiteToMove ? "winc" : "binc"))
+          limits.incrementMs = value;
+        else if (token == "movestogo")
+          limits.movesToGo = int(value);
+        else if (token == "movetime")
+          limits.moveTimeMs = value;
+        else if (token == "depth")
+          limits.depth = int(value);
+        else if (token == "nodes")
+          limits.nodes = uint64_t(value);
+      }
+
+      if (infinite)
+      {
+        SearchLimits unlimited = {};
+        unlimited.depth = limits.depth;
+        unlimited.nodes = limits.nodes;
+        limits = unlimited;
+      }
+
+      rootWhiteToMove = board.whiteToMove;
+      setIterationCallback(reportIteration);
+      setPondering(ponder);
+      holdBestMove = infinite || ponder;
+      infiniteSearch = infinite;
+      searchDone = false;
+      worker = std::thread([this, limits] {
+        Move best = findBestMove(board, limits);
+        std::unique_lock<std::mutex> lock(searchMutex);
+        searchChanged.wait(lock, [this] { return !holdBestMove; });
+        if (statsJson)
+        {
+          send("info string " + searchStatsJson(lastSearchStats()));
+        }
+        send("bestmove " + moveToUci(packMove(board, best)));
+        searchDone = true;
+        searchChanged.notify_all();
+      });
+    }
+
+    // setoption name <Hash|Threads|StatsJson|Ponder> value <n|true|false>
+    void setOption(std::istringstream &in)
+    {
+      waitForSearch();
+      std::string token, name, value;
+      in >> token >> name >> token >> value;
+      if (name == "Hash")
+        TT.resize(size_t(std::max(1LL, std::atoll(value.c_str()))));
+      else if (name == "Threads")
+        setSearchThreads(std::atoi(value.c_str()));
+      else if (name == "StatsJson")
+        statsJson = value == "true";
+      else if (name != "Ponder") // Ponder only says the GUI may send "go ponder"
+        send("info string unknown option " + name);
+    }
+  };
+}
+
+void uciLoop(const std::string &firstCommand)
+{
+  Uci uci;
+  std::string line = firstCommand;
+  while (uci.execute(line) && std::getline(std::cin, line))
+  {
+  }
+}
@@ -0,0 +1,12 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <string>
+
+// Speaks the UCI protocol on stdin/stdout until "quit" or end of input,
+// starting with 'firstCommand' if one was already read. Searches run on a
+// worker thread, so "stop" and "isready" are answered while one is in
+// progress.
+void uciLoop(const std::string &firstCommand = "");
+
+#endif // UCI_H
@@ -0,0 +1,51 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Random keys for Zobrist hashing. A position's key is the XOR of the keys
+// of every piece on its square, the side key when black is to move, one key
+// per castling right still available and the en passant file key.
+struct ZobristKeys
+{
+  uint64_t pieces[16][64]; // Indexed by Piece, then square
+  uint64_t castling[4];    // White king side, white queen side, black king side, black queen side
+  uint64_t enPassant[8];   // Indexed by file
+  uint64_t side;           // Black to move
+};
+
+// splitmix64 step, usable at compile time
+constexpr uint64_t zobristNext(uint64_t &state)
+{
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys()
+{
+  ZobristKeys keys{};
+  uint64_t state = 1070372;
+  for (int piece = 0; piece < 16; piece++)
+  {
+    for (int square = 0; square < 64; square++)
+    {
+      keys.pieces[piece][square] = zobristNext(state);
+    }
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    keys.castling[i] = zobristNext(state);
+  }
+  for (int file = 0; file < 8; file++)
+  {
+    keys.enPassant[file] = zobristNext(state);
+  }
+  keys.side = zobristNext(state);
+  return keys;
+}
+
+inline constexpr ZobristKeys Zobrist = makeZobristKeys();
+
+#endif // ZOBRIST_H